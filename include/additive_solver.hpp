@@ -0,0 +1,303 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_ADDITIVE_SOLVER_HPP
+#define PREDICTING_RANDOM_ADDITIVE_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// ADDITIVE SOLVER EXPLANATION
+//
+// TYPE_3 is one member of the family of additive lagged Fibonacci generators
+//  x_{i} := x_{i-R} + x_{i-S} (mod 2^32), 0 < S < R,
+// emitting o_{i} = x_{i} >> 1; the other glibc types use (7, 3), (15, 1) and
+// (63, 1), while other libraries use lags as large as (607, 273). Every argument
+// of solver.hpp carries over with 31 and 3 replaced by R and S: a carry event
+// indicates that the parities of x_{i-R} and x_{i-S} are 1, and the parities of
+// the first R outputs are the unknowns.
+//
+// With hundreds of unknowns, the equations no longer fit in a semicanonical
+// matrix, so they are collected in a gf2_matrix (see gf2_matrix.hpp) instead and
+// eliminated in bulk once enough of them may be independent. If the rank falls
+// short, further equations are collected and the elimination is repeated.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <bit>
+#include <limits>
+#include <memory>
+#include <optional>
+
+#include "cyclic_fixed_queue.hpp"
+#include "gf2_matrix.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief A generator which produces output equivalent to the additive lagged
+ *        Fibonacci generator with lags \a R and \a S, emitting all but the LSB of
+ *        each state.
+ *
+ * `additive_lagged_generator<31, 3>` is equivalent to #reference_generator. This
+ * type satisfies the concept `std::uniform_random_bit_generator`.
+ */
+template<std::size_t R, std::size_t S>
+  requires (0 < S && S < R)
+class additive_lagged_generator
+{
+public:
+  using result_type = std::uint32_t;
+  using table_type  = cyclic_fixed_queue<result_type, R>;
+
+  static constexpr std::size_t long_lag  = R;
+  static constexpr std::size_t short_lag = S;
+
+  static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+  static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max() >> 1; }
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Initializes the generator using \a seed, as glibc `srandom()` does for
+   *        the state of the same lags.
+   *
+   * This matches glibc for the lags (7, 3), (15, 1), (31, 3) and (63, 1).
+   */
+  explicit constexpr additive_lagged_generator(result_type seed) noexcept
+    : queue_(table_from_seed(seed))
+  {
+    for (std::size_t i = 0; i < 10 * R; ++i)
+      advance();
+  }
+
+  /**
+   * \brief Initializes the internal state directly from \a table, ordered from
+   *        oldest to most recent word.
+   */
+  explicit constexpr additive_lagged_generator(const table_type& table) noexcept : queue_(table) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const additive_lagged_generator&, const additive_lagged_generator&) = default;
+
+  /**
+   * \brief Returns the next internal state value.
+   */
+  [[nodiscard]] constexpr result_type peek_state() const noexcept
+  {
+    return queue_(-static_cast<std::ptrdiff_t>(R)) + queue_(-static_cast<std::ptrdiff_t>(S));
+  }
+
+  /**
+   * \brief Returns the next output value.
+   */
+  [[nodiscard]] constexpr result_type peek() const noexcept { return peek_state() >> 1; }
+
+  /**
+   * \brief Returns a reference to the internal state.
+   */
+  [[nodiscard]] constexpr const table_type& table() const noexcept { return queue_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type advance() noexcept { return queue_.pop_and_push(peek_state()) >> 1; }
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type operator()() noexcept { return advance(); }
+
+private:
+  table_type queue_;
+
+  /**
+   * \brief Returns internal state for a generator using \a seed.
+   */
+  [[nodiscard]] static constexpr table_type table_from_seed(result_type seed) noexcept;
+};
+
+template<std::size_t R, std::size_t S>
+  requires (0 < S && S < R)
+constexpr auto additive_lagged_generator<R, S>::table_from_seed(result_type seed) noexcept
+  -> table_type
+{
+  table_type result;
+  result.push(seed == 0 ? 1u : seed);
+  for (std::size_t i = 1; i < R; ++i) {
+    // cast here is necessary to maintain the sign of the operation
+    auto value = (16807LL * static_cast<std::int32_t>(result.back())) % 2147483647;
+    if (value < 0)
+      value += 2147483647;
+    result.push(static_cast<result_type>(value));
+  }
+
+  for (std::size_t i = 0; i < S; ++i)
+    result.pop_and_push(result_type(result.front()));
+
+  return result;
+}
+
+/**
+ * \brief A solver for #additive_lagged_generator.
+ */
+template<std::size_t R, std::size_t S>
+  requires (0 < S && S < R)
+class additive_lagged_solver
+{
+public:
+  using generator_type = additive_lagged_generator<R, S>; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  additive_lagged_solver() : parity(std::make_unique<parity_queue>())
+  {
+    for (std::size_t i = 0; i < R; ++i) {
+      row_type unit{};
+      unit[i / 64] = std::uint64_t(1) << (i % 64);
+      parity->push(unit);
+    }
+  }
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the number of independent equations found so far.
+   */
+  [[nodiscard]] std::size_t rank() const noexcept { return equations.rank(); }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value from the PRNG.
+   *
+   * \return A generator positioned after \a value, once the state is determined.
+   */
+  [[nodiscard]] std::optional<generator_type> feed(value_type value);
+
+private:
+  using matrix_type = gf2_matrix<R + 1>; ///< The last column is the constant `1`.
+  using row_type    = typename matrix_type::row_type;
+  using parity_queue = cyclic_fixed_queue<row_type, R>;
+
+  /**
+   * \brief The number of equations collected beyond the unknowns before
+   *        eliminating, as some are usually dependent.
+   */
+  static constexpr std::size_t surplus = 16;
+
+  std::size_t fed = 0;                         ///< The number of values fed, up to R.
+  typename generator_type::table_type history; ///< Keeps track of recent values.
+  std::unique_ptr<parity_queue> parity;        ///< Parities of recent states in
+                                               ///< terms of the parities of the
+                                               ///< first R outputs.
+  matrix_type equations;
+  std::size_t pending = 0; ///< The number of equations collected since the last
+                           ///< elimination.
+
+  /**
+   * \brief Records that the parity given by \a coefficients is 1.
+   */
+  void push_one(row_type coefficients)
+  {
+    coefficients[R / 64] |= std::uint64_t(1) << (R % 64);
+    equations.push_row(coefficients);
+    ++pending;
+  }
+
+  /**
+   * \brief Reconstructs the target generator.
+   *
+   * \return A generator producing equivalent output to the one which fed the solver
+   *         values.
+   */
+  [[nodiscard]] generator_type solve() const noexcept;
+};
+
+template<std::size_t R, std::size_t S>
+  requires (0 < S && S < R)
+auto additive_lagged_solver<R, S>::feed(value_type value) -> std::optional<generator_type>
+{
+  constexpr auto r = static_cast<std::ptrdiff_t>(R);
+  constexpr auto s = static_cast<std::ptrdiff_t>(S);
+
+  if (fed < R) {
+    history.push(value);
+    ++fed;
+    return std::nullopt;
+  }
+
+  const auto expected = (history(-r) + history(-s)) & generator_type::max();
+  history.pop_and_push(value);
+
+  auto& queue = *parity;
+  const row_type qr = queue(-r); // p_{i-R} in terms of initial parities
+  const row_type qs = queue(-s); // p_{i-S} in terms of initial parities
+  row_type& next = queue.pop_and_push(qr);
+  for (std::size_t w = 0; w < next.size(); ++w)
+    next[w] ^= qs[w];
+
+  if (value == expected)
+    return std::nullopt;
+
+  assert(value == ((expected + 1u) & generator_type::max()));
+  push_one(qr);
+  push_one(qs);
+
+  if (equations.rank() + pending < R + surplus)
+    return std::nullopt;
+
+  pending = 0;
+  if (equations.eliminate(R) < R)
+    return std::nullopt;
+
+  return solve();
+}
+
+template<std::size_t R, std::size_t S>
+  requires (0 < S && S < R)
+auto additive_lagged_solver<R, S>::solve() const noexcept -> generator_type
+{
+  assert(equations.rank() == R);
+
+  row_type initial_state{};
+  for (std::size_t i = 0; i < R; ++i) {
+    const auto unknown = equations.pivot(i);
+    if (equations.test(i, R)) // last column indicates parity
+      initial_state[unknown / 64] |= std::uint64_t(1) << (unknown % 64);
+  }
+
+  auto table = history;
+  for (auto it = parity->begin(); auto& state : table) {
+    int ones = 0;
+    for (std::size_t w = 0; w < initial_state.size(); ++w)
+      ones += std::popcount((*it)[w] & initial_state[w]);
+    ++it;
+
+    state = (state << 1) | static_cast<value_type>(ones % 2);
+  }
+
+  return generator_type{table};
+}
+
+}
+
+#endif // PREDICTING_RANDOM_ADDITIVE_SOLVER_HPP
@@ -0,0 +1,376 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_COMBINED_SOLVER_HPP
+#define PREDICTING_RANDOM_COMBINED_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// COMBINED SOLVER EXPLANATION
+//
+// Wide values are frequently built from two calls, as in
+//  ((uint64_t)random() << 31) | random(), or
+//  random() ^ ((uint64_t)random() << 16).
+// The order in which the two calls are made is unspecified in both C and C++, and
+// differs between compilers, so it is supplied to the solvers as a call_order.
+//
+// For shifts of at least 31 bits the two outputs do not overlap, and each combined
+// value decomposes into two exact outputs, which are fed to solver in call order.
+//
+// For smaller shifts S, write the combined value as a ^ (b << S). Only the low S
+// bits of a, and the high S bits of b, are exposed directly; the bits in between
+// are a mix of both. Following the notation in solver.hpp, the states of the calls
+// producing a (one in every two steps) satisfy the recurrence applied twice:
+//  x_{k} = x_{k-3} + 2 * x_{k-17} + x_{k-31} (mod 2^32),
+// where k counts combined values. Then, as in solver.hpp, modulo 2^S,
+//  a_{k} - a_{k-3} - 2 * a_{k-17} - a_{k-31} = p_{k-17} + p_{k-3} * p_{k-31},
+// where p_{k} = x_{k} mod 2, and the parities p_{k} follow the same recurrence as
+// in solver.hpp. A difference of 0 implies p_{k-17} = 0 and a difference of 2
+// implies p_{k-17} = p_{k-3} = p_{k-31} = 1; these equations are collected in a
+// parity_system until the parities of the calls producing a are known.
+//
+// The low S+1 bits of the states producing a are then known, which determines the
+// low S+1 bits of the states producing b through the original recurrence, as their
+// lags 3 and 31 both land on calls producing a. Removing the known low bits of b
+// from the mixed bits reveals S more bits of a, and repeating this lifts both
+// calls to full states after about 16 * 31/S combined values.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+
+#include "cyclic_fixed_queue.hpp"
+#include "prng.hpp"
+#include "solver.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief The order in which the two calls producing a combined value are made.
+ */
+enum class call_order
+{
+  high_first, ///< The call providing the shifted (high) bits is made first.
+  low_first,  ///< The call providing the unshifted (low) bits is made first.
+};
+
+/**
+ * \brief The bits of a single output exposed by a combined value.
+ */
+struct partial_output
+{
+  std::uint32_t value; ///< The output, where bits outside of #mask are zero.
+  std::uint32_t mask;  ///< The bits of the output that are known.
+};
+
+/**
+ * \brief Splits a combined value `lo | (hi << shift)` (or `lo ^ (hi << shift)`) into
+ *        the bits directly exposed for each call, in call order.
+ *
+ * For \a shift of at least 31 both outputs are fully exposed. For smaller \a shift
+ * the bits mixed between both outputs are left out.
+ */
+[[nodiscard]] constexpr std::array<partial_output, 2> split_combined(
+  std::uint64_t value,
+  int           shift,
+  call_order    order) noexcept
+{
+  assert(1 <= shift && shift <= 33);
+  constexpr std::uint32_t output_mask = reference_generator::max();
+
+  const std::uint32_t low_mask  = shift >= 31 ? output_mask : output_mask >> (31 - shift);
+  const std::uint32_t high_mask = shift >= 31 ? output_mask : (output_mask << (31 - shift)) & output_mask;
+
+  const partial_output low{
+    .value = static_cast<std::uint32_t>(value) & low_mask,
+    .mask  = low_mask};
+  const partial_output high{
+    .value = static_cast<std::uint32_t>(value >> shift) & high_mask,
+    .mask  = high_mask};
+
+  return order == call_order::low_first ? std::array{low, high} : std::array{high, low};
+}
+
+/**
+ * \brief A solver for #reference_generator which observes values built from two
+ *        outputs as `((uint64_t)hi << Shift) | lo`.
+ *
+ * As the outputs do not overlap, `^` and `+` may equally be used to combine them.
+ */
+template<int Shift>
+  requires (31 <= Shift && Shift <= 33)
+class concatenated_solver
+{
+public:
+  using generator_type = reference_generator; ///< The targeted generator type.
+  using value_type = std::uint64_t;
+
+  static constexpr int shift = Shift; ///< The shift applied to the high output.
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed values produced by calls
+   *        in the given \a order.
+   */
+  explicit constexpr concatenated_solver(call_order order = call_order::high_first) noexcept
+    : order_(order) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the order of the calls producing each value.
+   */
+  [[nodiscard]] constexpr call_order order() const noexcept { return order_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds a combined \a value, produced by two calls to the PRNG.
+   *
+   * \return A generator positioned after the second call, once solved.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept;
+
+private:
+  call_order order_;
+  solver     inner;
+};
+
+/**
+ * \brief A solver for #reference_generator which observes values built from two
+ *        outputs as `lo ^ ((uint64_t)hi << Shift)`.
+ *
+ * The value must be fed at its full width of `31 + Shift` bits.
+ */
+template<int Shift>
+  requires (2 <= Shift && Shift <= 30)
+class xor_shifted_solver
+{
+public:
+  using generator_type = reference_generator; ///< The targeted generator type.
+  using value_type = std::uint64_t;
+
+  static constexpr int shift = Shift; ///< The shift applied to the high output.
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed values produced by calls
+   *        in the given \a order.
+   */
+  explicit constexpr xor_shifted_solver(call_order order = call_order::high_first) noexcept
+    : order_(order) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the order of the calls producing each value.
+   */
+  [[nodiscard]] constexpr call_order order() const noexcept { return order_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds a combined \a value, produced by two calls to the PRNG.
+   *
+   * \return A generator positioned after the second call, once solved.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept;
+
+private:
+  static constexpr std::uint32_t low_mask = reference_generator::max() >> (31 - Shift);
+
+  /**
+   * \brief The low #bits bits of an internal state.
+   */
+  struct partial_state
+  {
+    std::uint32_t value = 0;
+    int           bits  = 0;
+  };
+
+  /**
+   * \brief The partial internal states of the two calls producing one value.
+   */
+  struct pair_state
+  {
+    partial_state low;  ///< The call providing the unshifted bits.
+    partial_state high; ///< The call providing the shifted bits.
+  };
+
+  call_order order_;
+  cyclic_fixed_queue<value_type, 31> history;  ///< Recent values, until solved.
+  parity_system parities;                      ///< Parities of the low calls.
+  cyclic_fixed_queue<pair_state, 31> lifted;   ///< Recent partial states, once the
+                                               ///< parities are solved.
+  int complete = 0; ///< The number of recent pairs of fully known states.
+
+  /**
+   * \brief Seeds #lifted with the low bits of the most recent low calls.
+   *
+   * The parity system must be solvable, i.e. `parities.solvable()`.
+   */
+  constexpr void start_lifting() noexcept;
+
+  /**
+   * \brief Lifts the partial states of the calls producing \a value from the
+   *        preceding partial states.
+   */
+  [[nodiscard]] constexpr pair_state lift(value_type value) const noexcept;
+
+  /**
+   * \brief Reconstructs the target generator from the most recent pairs, which must
+   *        all be fully known.
+   */
+  [[nodiscard]] constexpr generator_type solve() const noexcept;
+};
+
+template<int Shift> requires (31 <= Shift && Shift <= 33)
+constexpr auto concatenated_solver<Shift>::feed(value_type value) noexcept
+  -> std::optional<generator_type>
+{
+  const auto [first, second] = split_combined(value, Shift, order_);
+
+  if (auto gen = inner.feed(first.value)) {
+    [[maybe_unused]] const auto next = gen->advance();
+    assert(next == second.value);
+    return gen;
+  }
+
+  return inner.feed(second.value);
+}
+
+template<int Shift> requires (2 <= Shift && Shift <= 30)
+constexpr auto xor_shifted_solver<Shift>::feed(value_type value) noexcept
+  -> std::optional<generator_type>
+{
+  if (!lifted.empty()) {
+    const auto pair = lift(value);
+    lifted.pop_and_push(pair);
+
+    complete = pair.low.bits == 32 && pair.high.bits == 32 ? complete + 1 : 0;
+    if (complete < 16)
+      return std::nullopt;
+
+    return solve();
+  }
+
+  if (history.ssize() < 31) {
+    history.push(value);
+    parities.advance();
+    return std::nullopt;
+  }
+
+  const auto a31 = static_cast<std::uint32_t>(history(-31)) & low_mask; // a_{k-31}
+  const auto a17 = static_cast<std::uint32_t>(history(-17)) & low_mask; // a_{k-17}
+  const auto a3  = static_cast<std::uint32_t>(history(-3))  & low_mask; // a_{k-3}
+  const auto lag17 = parities.parity_at(-17);
+
+  history.pop_and_push(value);
+  const auto step = parities.advance();
+
+  const auto difference = (static_cast<std::uint32_t>(value) - a3 - 2 * a17 - a31) & low_mask;
+  assert(difference <= 2);
+
+  bool solvable = false;
+  if (difference == 0) {
+    solvable = parities.push_parity(lag17, false);
+  } else if (difference == 2) {
+    solvable = parities.push_parity(lag17, true);
+    solvable = parities.push_carry(step) || solvable;
+  }
+
+  if (solvable)
+    start_lifting();
+
+  return std::nullopt;
+}
+
+template<int Shift> requires (2 <= Shift && Shift <= 30)
+constexpr void xor_shifted_solver<Shift>::start_lifting() noexcept
+{
+  assert(parities.solvable());
+
+  // parity_bits ordered from oldest (LSB) to most recent (MSB)
+  auto parity_bits = parities.solve_parities();
+  for (const auto value : history) {
+    const auto a = static_cast<std::uint32_t>(value) & low_mask;
+    lifted.push({.low = {.value = (a << 1) | (parity_bits & 1u), .bits = Shift + 1}, .high = {}});
+    parity_bits >>= 1;
+  }
+}
+
+template<int Shift> requires (2 <= Shift && Shift <= 30)
+constexpr auto xor_shifted_solver<Shift>::lift(value_type value) const noexcept
+  -> pair_state
+{
+  const auto mask = [](int bits) { return bits >= 32 ? ~std::uint32_t(0) : (std::uint32_t(1) << bits) - 1u; };
+
+  // the high call's lags 3 and 31 are low calls, which depends on the call order
+  const int lag = order_ == call_order::low_first ? 1 : 2;
+  const auto& x3  = lifted(-lag).low;
+  const auto& x31 = lifted(-lag - 14).low;
+
+  pair_state result;
+  result.high.bits  = std::min(x3.bits, x31.bits);
+  result.high.value = (x3.value + x31.value) & mask(result.high.bits);
+
+  // removing the known low bits of the high output from the mixed bits
+  const int  high_bits  = result.high.bits - 1;
+  const auto high_value = result.high.value >> 1;
+  const int  low_bits   = std::min(31, Shift + high_bits);
+  const auto low_value  = (static_cast<std::uint32_t>(value) ^ (high_value << Shift)) & mask(low_bits);
+
+  // the parities of the low calls follow the recurrence, see solver.hpp
+  const auto parity = (lifted(-3).low.value ^ lifted(-31).low.value) & 1u;
+  result.low = {.value = (low_value << 1) | parity, .bits = low_bits + 1};
+
+  [[maybe_unused]] const auto exposed = split_combined(value, Shift, call_order::low_first)[1];
+  assert((high_value & exposed.mask & mask(high_bits)) == (exposed.value & mask(high_bits)));
+
+  return result;
+}
+
+template<int Shift> requires (2 <= Shift && Shift <= 30)
+constexpr auto xor_shifted_solver<Shift>::solve() const noexcept -> generator_type
+{
+  assert(complete >= 16);
+
+  generator_type::table_type table;
+  const auto push = [&table](std::uint32_t state) {
+    if (table.ssize() < 31)
+      table.push(state);
+    else
+      table.pop_and_push(state);
+  };
+
+  for (int i = -16; i < 0; ++i) {
+    const auto& pair = lifted(i);
+    if (order_ == call_order::low_first) {
+      push(pair.low.value);
+      push(pair.high.value);
+    } else {
+      push(pair.high.value);
+      push(pair.low.value);
+    }
+  }
+
+  return generator_type{table};
+}
+
+}
+
+#endif // PREDICTING_RANDOM_COMBINED_SOLVER_HPP
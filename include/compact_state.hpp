@@ -0,0 +1,177 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_COMPACT_STATE_HPP
+#define PREDICTING_RANDOM_COMPACT_STATE_HPP
+
+// ---------------------------------------------------------------------------------
+// COMPACT STATE EXPLANATION
+//
+// Once the seed of a generator is known, its state is determined by the seed and
+// the number of outputs generated since seeding, the offset. compact_state keeps
+// only these, in 16 bytes against the 31 words of a table, and rebuilds the table
+// when the generator is needed: the table is seeded, and then advanced over the
+// outputs discarded by seeding and the offset in one jump (see discard() in
+// prng.hpp).
+//
+// A program that keeps many states, most of them idle, pairs them with a
+// compact_table_cache. The cache remembers the tables of the states used most
+// recently, so a state that is used again soon resumes from its table, and a state
+// that has advanced past a remembered table is advanced from it rather than rebuilt
+// from its seed.
+//
+// IMPLEMENTATION NOTES
+// The cache is direct-mapped on the seed: each seed has one slot, and a state
+// replaces whichever table was in its slot when it is remembered. A lookup is then a
+// single comparison, and the cache never allocates. Caches are not synchronized;
+// each thread should use its own.
+// ---------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+
+#include "prng.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief The state of a #reference_generator with a known seed, kept as the seed and
+ *        the number of outputs generated since seeding.
+ */
+class compact_state
+{
+public:
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to the state of a generator seeded by \a seed, after \a offset
+   *        outputs.
+   */
+  explicit constexpr compact_state(std::uint32_t seed, std::uint64_t offset = 0) noexcept
+    : offset_(offset), seed_(seed) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const compact_state&, const compact_state&) = default;
+
+  /**
+   * \brief Returns the seed.
+   */
+  [[nodiscard]] constexpr std::uint32_t seed() const noexcept { return seed_; }
+
+  /**
+   * \brief Returns the number of outputs generated since seeding.
+   */
+  [[nodiscard]] constexpr std::uint64_t offset() const noexcept { return offset_; }
+
+  /**
+   * \brief Returns the generator in this state.
+   */
+  template<reference_generator_backend Backend = ring_backend>
+  [[nodiscard]] constexpr basic_reference_generator<Backend> generator() const noexcept
+  {
+    return basic_reference_generator<Backend>(seed_, offset_);
+  }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Advances the state by \a count outputs.
+   */
+  constexpr void advance(std::uint64_t count) noexcept { offset_ += count; }
+
+private:
+  std::uint64_t offset_;
+  std::uint32_t seed_;
+};
+
+/**
+ * \brief A cache of the tables of recently used #compact_state, holding at most one
+ *        table for each of \a Slots groups of seeds.
+ */
+template<std::size_t Slots = 64>
+  requires (std::has_single_bit(Slots) && Slots <= (std::size_t(1) << 31))
+class compact_table_cache
+{
+public:
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the generator in \a state, advanced from the table remembered for
+   *        its seed if that table is at or before \a state.
+   */
+  [[nodiscard]] constexpr reference_generator generator(const compact_state& state) const noexcept
+  {
+    const entry& slot = slots[slot_of(state.seed())];
+    if (!slot.valid || slot.seed != state.seed() || slot.offset > state.offset())
+      return state.generator();
+
+    reference_table table;
+    table.push_range(std::span<const std::uint32_t>(slot.words));
+
+    reference_generator result(table);
+    result.discard(state.offset() - slot.offset);
+    return result;
+  }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Remembers that \a gen is in \a state, replacing the table remembered for
+   *        the slot of its seed.
+   */
+  template<typename Backend>
+  constexpr void remember(const compact_state& state, const basic_reference_generator<Backend>& gen) noexcept
+  {
+    entry& slot = slots[slot_of(state.seed())];
+    slot.valid = true;
+    slot.seed = state.seed();
+    slot.offset = state.offset();
+    std::ranges::copy(gen.table(), slot.words.begin());
+  }
+
+  /**
+   * \brief Forgets all remembered tables.
+   */
+  constexpr void clear() noexcept { slots = {}; }
+
+private:
+  struct entry
+  {
+    std::uint64_t offset = 0;
+    std::uint32_t seed = 0;
+    bool valid = false;
+    std::array<std::uint32_t, 31> words{};
+  };
+
+  std::array<entry, Slots> slots{};
+
+  /**
+   * \brief Returns the slot of \a seed, mixing its bits by a multiplicative hash so
+   *        that consecutive seeds spread over the slots.
+   */
+  [[nodiscard]] static constexpr std::size_t slot_of(std::uint32_t seed) noexcept
+  {
+    if constexpr (Slots == 1)
+      return 0;
+    else
+      return static_cast<std::size_t>((seed * std::uint32_t(2654435761u)) >> (32 - std::countr_zero(Slots)));
+  }
+};
+
+}
+
+#endif // PREDICTING_RANDOM_COMPACT_STATE_HPP
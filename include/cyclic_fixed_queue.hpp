@@ -11,49 +11,76 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <concepts>
 #include <iterator>
 #include <memory>
+#include <span>
+#include <type_traits>
 #include <utility>
 
 namespace predicting_random
 {
 
 /**
- * \brief A bidirectional iterator wrapper which provides an iterator that cycles 
+ * \brief A random access iterator wrapper which provides an iterator that cycles 
  *        through a given range.
+ *
+ * The iterator keeps its position as an index relative to an origin in the range,
+ * so that iterators over the same cycle can be compared and subtracted even when
+ * one of them has wrapped around.
  */
-template<typename BidirIt>
+template<std::random_access_iterator RandomIt>
 class wrap_around_iterator
 {
 public:
-  using difference_type = typename std::iterator_traits<BidirIt>::difference_type;
-  using value_type = typename std::iterator_traits<BidirIt>::value_type;
-  using pointer = typename std::iterator_traits<BidirIt>::pointer;
-  using reference = typename std::iterator_traits<BidirIt>::reference;
-  using iterator_category = std::bidirectional_iterator_tag;
+  using difference_type = std::iter_difference_t<RandomIt>;
+  using value_type = std::iter_value_t<RandomIt>;
+  using pointer = typename std::iterator_traits<RandomIt>::pointer;
+  using reference = std::iter_reference_t<RandomIt>;
+  using iterator_category = std::random_access_iterator_tag;
+  using iterator_concept = std::random_access_iterator_tag;
   
   friend constexpr bool operator==(
     const wrap_around_iterator& lhs, 
     const wrap_around_iterator& rhs) noexcept
   {
-    return lhs.it == rhs.it;
+    return lhs.index == rhs.index;
+  }
+  
+  friend constexpr auto operator<=>(
+    const wrap_around_iterator& lhs, 
+    const wrap_around_iterator& rhs) noexcept
+  {
+    return lhs.index <=> rhs.index;
   }
   
   wrap_around_iterator() = default;
   
   /**
-   * \brief Constructs an iterator that cycles over the range `[reset, last)`, 
-   *        starting at \a it.
+   * \brief Constructs an iterator that cycles over the \a length elements starting
+   *        at \a reset, positioned \a index elements past the element at
+   *        \a origin.
    */
-  explicit constexpr wrap_around_iterator(BidirIt it, BidirIt last, BidirIt reset) noexcept
-    : it(it), last(last), reset(reset) {}
+  explicit constexpr wrap_around_iterator(
+    RandomIt        reset, 
+    difference_type length, 
+    difference_type origin, 
+    difference_type index) noexcept
+    : reset(reset), length(length), origin(origin), index(index) {}
+  
+  constexpr reference operator*() const noexcept
+  {
+    auto offset = origin + index;
+    if (offset >= length)
+      offset -= length;
+    return reset[offset];
+  }
   
-  constexpr reference operator*() noexcept { return *it; }
+  constexpr reference operator[](difference_type n) const noexcept { return *(*this + n); }
   
   constexpr wrap_around_iterator& operator++() noexcept {
-    if (++it == last)
-      it = reset;
+    ++index;
     return *this;
   }
   
@@ -64,8 +91,7 @@ public:
   }
   
   constexpr wrap_around_iterator& operator--() noexcept {
-    if (it == reset)
-      it = std::prev(last);
+    --index;
     return *this;
   }
   
@@ -74,9 +100,62 @@ public:
     --(*this);
     return copy;
   }
+  
+  constexpr wrap_around_iterator& operator+=(difference_type n) noexcept {
+    index += n;
+    return *this;
+  }
+  
+  constexpr wrap_around_iterator& operator-=(difference_type n) noexcept {
+    index -= n;
+    return *this;
+  }
+  
+  friend constexpr wrap_around_iterator operator+(wrap_around_iterator it, difference_type n) noexcept
+  {
+    return it += n;
+  }
+  
+  friend constexpr wrap_around_iterator operator+(difference_type n, wrap_around_iterator it) noexcept
+  {
+    return it += n;
+  }
+  
+  friend constexpr wrap_around_iterator operator-(wrap_around_iterator it, difference_type n) noexcept
+  {
+    return it -= n;
+  }
+  
+  friend constexpr difference_type operator-(
+    const wrap_around_iterator& lhs, 
+    const wrap_around_iterator& rhs) noexcept
+  {
+    return lhs.index - rhs.index;
+  }
 
 private:
-  BidirIt it, last, reset;
+  RandomIt reset{};
+  difference_type length = 0; ///< The number of elements in the cycle.
+  difference_type origin = 0; ///< The offset of the element at index `0`.
+  difference_type index  = 0;
+};
+
+/**
+ * \brief Selects the cursor stored by #cyclic_fixed_queue.
+ */
+enum class queue_cursor
+{
+  front, ///< The read cursor is stored; suits queues that are pushed and popped.
+  back,  ///< The write cursor is stored; suits full queues accessed from the back.
+};
+
+/**
+ * \brief Selects how #cyclic_fixed_queue lays out its elements.
+ */
+enum class queue_storage
+{
+  single,   ///< Each element is stored once.
+  mirrored, ///< Each element is stored twice, so that the queue is contiguous.
 };
 
 /**
@@ -85,21 +164,37 @@ private:
  * Unlike other containers like `std::vector`, all storage elements are constructed
  * and destroyed with the queue. If \a T is not trivially destructible, elements 
  * are popped by assigning them the default-constructed value.
+ *
+ * The queue stores its size and a single cursor, selected by \a Cursor, from which
+ * the other end is derived. Offsets relative to the stored cursor take one addition
+ * and one reduction, which is a mask when `Capacity + 1` is a power of two.
+ *
+ * With #queue_storage::mirrored as \a Storage, every element is written both at its
+ * index and one cycle past it, doubling the cost of pushes and the storage. In
+ * exchange, any run of elements in the queue is contiguous in storage, as returned
+ * by #window, and iterators are plain pointers. Elements are then only accessible
+ * as `const`, so that the copies cannot diverge.
  */
-template<std::semiregular T, std::size_t Capacity>
+template<
+  std::semiregular T, 
+  std::size_t      Capacity, 
+  queue_cursor     Cursor  = queue_cursor::front,
+  queue_storage    Storage = queue_storage::single>
 class cyclic_fixed_queue
 {
+  static constexpr bool mirrored = Storage == queue_storage::mirrored;
+  
 public:
   using value_type = T;
   using size_type = std::size_t;
   using difference_type = std::ptrdiff_t;
-  using reference = value_type&;
+  using reference = std::conditional_t<mirrored, const value_type&, value_type&>;
   using const_reference = const value_type&;
-  using pointer = value_type*;
+  using pointer = std::conditional_t<mirrored, const value_type*, value_type*>;
   using const_pointer = const value_type*;
   
-  using iterator = wrap_around_iterator<pointer>;
-  using const_iterator = wrap_around_iterator<const_pointer>;
+  using iterator = std::conditional_t<mirrored, pointer, wrap_around_iterator<pointer>>;
+  using const_iterator = std::conditional_t<mirrored, const_pointer, wrap_around_iterator<const_pointer>>;
   
   using reverse_iterator = std::reverse_iterator<iterator>;
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
@@ -131,7 +226,20 @@ public:
     if (lhs.size() != rhs.size())
       return false;
     
-    return std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    // compare contiguous ranges, so that this reduces to memcmp where possible
+    auto [l0, l1] = lhs.segments();
+    auto [r0, r1] = rhs.segments();
+    if (l0.size() > r0.size()) {
+      std::swap(l0, r0);
+      std::swap(l1, r1);
+    }
+    
+    // l0 ends within r0, which ends within l1
+    const auto k = l0.size();
+    const auto m = r0.size() - k;
+    return std::equal(l0.begin(), l0.end(), r0.begin())
+      && std::equal(r0.begin() + k, r0.end(), l1.begin())
+      && std::equal(l1.begin() + m, l1.end(), r1.begin());
   }
   
   /**
@@ -139,7 +247,7 @@ public:
    */
   [[nodiscard]] constexpr reference front() noexcept {
     assert(!empty());
-    return storage_[front_];
+    return storage_[front_index()];
   }
   
   /**
@@ -147,7 +255,7 @@ public:
    */
   [[nodiscard]] constexpr const_reference front() const noexcept {
     assert(!empty());
-    return storage_[front_];
+    return storage_[front_index()];
   }
   
   /**
@@ -155,7 +263,7 @@ public:
    */
   [[nodiscard]] constexpr reference back() noexcept {
     assert(!empty());
-    return storage_[(front_ + ssize() - 1) % std::ssize(storage_)];
+    return at<-1>();
   }
   
   /**
@@ -163,7 +271,7 @@ public:
    */
   [[nodiscard]] constexpr const_reference back() const noexcept {
     assert(!empty());
-    return storage_[(front_ + ssize() - 1) % std::ssize(storage_)];
+    return at<-1>();
   }
   
   /**
@@ -177,10 +285,10 @@ public:
   {
     if (offset < 0) {
       assert(ssize() + offset >= 0);
-      return storage_[(front_ + ssize() + offset) % std::ssize(storage_)];
+      return storage_[wrap(back_cursor() + offset)];
     } else {
       assert(ssize() >= offset);
-      return storage_[(front_ + offset) % std::ssize(storage_)];
+      return storage_[wrap(front_cursor() + offset)];
     }
   }
   
@@ -194,9 +302,49 @@ public:
   [[nodiscard]] constexpr const_reference operator()(difference_type offset) const noexcept
   {
     if (offset < 0)
-      return storage_[(front_ + ssize() + offset) % std::ssize(storage_)];
+      return storage_[wrap(back_cursor() + offset)];
     else
-      return storage_[(front_ + offset) % std::ssize(storage_)];
+      return storage_[wrap(front_cursor() + offset)];
+  }
+  
+  /**
+   * \brief Returns a reference to the element at a relative \a Offset, known at
+   *        compile time.
+   *
+   * Offsets are interpreted as by `operator()`, but without a branch on the sign
+   * of the offset at run time.
+   */
+  template<difference_type Offset>
+    requires (-static_cast<difference_type>(Capacity) <= Offset && Offset < static_cast<difference_type>(Capacity))
+  [[nodiscard]] constexpr reference at() noexcept
+  {
+    if constexpr (Offset < 0) {
+      assert(ssize() + Offset >= 0);
+      return storage_[wrap(back_cursor() + Offset)];
+    } else {
+      assert(Offset < size_);
+      return storage_[wrap(front_cursor() + Offset)];
+    }
+  }
+  
+  /**
+   * \brief Returns a reference to the element at a relative \a Offset, known at
+   *        compile time.
+   *
+   * Offsets are interpreted as by `operator()`, but without a branch on the sign
+   * of the offset at run time.
+   */
+  template<difference_type Offset>
+    requires (-static_cast<difference_type>(Capacity) <= Offset && Offset < static_cast<difference_type>(Capacity))
+  [[nodiscard]] constexpr const_reference at() const noexcept
+  {
+    if constexpr (Offset < 0) {
+      assert(ssize() + Offset >= 0);
+      return storage_[wrap(back_cursor() + Offset)];
+    } else {
+      assert(Offset < size_);
+      return storage_[wrap(front_cursor() + Offset)];
+    }
   }
   
   /**
@@ -214,6 +362,63 @@ public:
    */
   [[nodiscard]] constexpr bool empty() const noexcept { return size() <= 0; }
   
+  /**
+   * \brief Returns the elements of the queue, in order, as at most two contiguous
+   *        ranges of storage.
+   *
+   * The second range is empty unless the queue wraps around its storage.
+   */
+  [[nodiscard]] constexpr std::array<std::span<std::remove_reference_t<reference>>, 2> segments() noexcept
+  {
+    const auto front = front_index();
+    const auto first = mirrored ? size_ : std::min(size_, storage_size - front);
+    return {
+      std::span<std::remove_reference_t<reference>>(storage_.data() + front, static_cast<size_type>(first)),
+      std::span<std::remove_reference_t<reference>>(storage_.data(), static_cast<size_type>(size_ - first))};
+  }
+  
+  /**
+   * \brief Returns the elements of the queue, in order, as at most two contiguous
+   *        ranges of storage.
+   *
+   * The second range is empty unless the queue wraps around its storage.
+   */
+  [[nodiscard]] constexpr std::array<std::span<const value_type>, 2> segments() const noexcept
+  {
+    const auto front = front_index();
+    const auto first = mirrored ? size_ : std::min(size_, storage_size - front);
+    return {
+      std::span<const value_type>(storage_.data() + front, static_cast<size_type>(first)),
+      std::span<const value_type>(storage_.data(), static_cast<size_type>(size_ - first))};
+  }
+  
+  /**
+   * \brief Returns the \a count elements starting at a relative \a offset as one
+   *        contiguous range of storage.
+   *
+   * \a offset is interpreted as by `operator()`. This is only available with
+   * #queue_storage::mirrored.
+   */
+  [[nodiscard]] constexpr std::span<const value_type> window(difference_type offset, size_type count) const noexcept
+    requires mirrored
+  {
+    const difference_type first = offset < 0 ? size_ + offset : offset;
+    assert(first >= 0 && std::cmp_less_equal(first + static_cast<difference_type>(count), size_));
+    return std::span<const value_type>(storage_.data() + wrap(front_cursor() + first), count);
+  }
+  
+  /**
+   * \brief Returns the elements of the queue, in order, as one contiguous range of
+   *        storage.
+   *
+   * This is only available with #queue_storage::mirrored.
+   */
+  [[nodiscard]] constexpr std::span<const value_type> contiguous() const noexcept
+    requires mirrored
+  {
+    return std::span<const value_type>(storage_.data() + front_index(), size());
+  }
+  
   // -------------------------------------------------------------------------------
   // ITERATORS
   
@@ -222,9 +427,10 @@ public:
    */
   [[nodiscard]] constexpr iterator begin() noexcept
   {
-    const auto reset = storage_.data();
-    const auto last = reset + std::ssize(storage_);
-    return iterator{std::addressof(front()), last, reset};
+    if constexpr (mirrored)
+      return storage_.data() + front_index();
+    else
+      return iterator{storage_.data(), storage_size, front_index(), 0};
   }
   
   /**
@@ -232,9 +438,10 @@ public:
    */
   [[nodiscard]] constexpr const_iterator begin() const noexcept
   {
-    const auto reset = storage_.data();
-    const auto last = reset + std::ssize(storage_);
-    return const_iterator{std::addressof(front()), last, reset};
+    if constexpr (mirrored)
+      return storage_.data() + front_index();
+    else
+      return const_iterator{storage_.data(), storage_size, front_index(), 0};
   }
   
   /**
@@ -242,9 +449,7 @@ public:
    */
   [[nodiscard]] constexpr const_iterator cbegin() const noexcept
   {
-    const auto reset = storage_.data();
-    const auto last = reset + std::ssize(storage_);
-    return const_iterator{std::addressof(front()), last, reset};
+    return begin();
   }
   
   /**
@@ -252,9 +457,10 @@ public:
    */
   [[nodiscard]] constexpr iterator end() noexcept
   {
-    const auto reset = storage_.data();
-    const auto last = reset + std::ssize(storage_);
-    return iterator{std::next(std::addressof(back())), last, reset};
+    if constexpr (mirrored)
+      return storage_.data() + front_index() + size_;
+    else
+      return iterator{storage_.data(), storage_size, front_index(), size_};
   }
   
   /**
@@ -262,9 +468,10 @@ public:
    */
   [[nodiscard]] constexpr const_iterator end() const noexcept
   {
-    const auto reset = storage_.data();
-    const auto last = reset + std::ssize(storage_);
-    return const_iterator{std::next(std::addressof(back())), last, reset};
+    if constexpr (mirrored)
+      return storage_.data() + front_index() + size_;
+    else
+      return const_iterator{storage_.data(), storage_size, front_index(), size_};
   }
   
   /**
@@ -272,9 +479,7 @@ public:
    */
   [[nodiscard]] constexpr const_iterator cend() const noexcept
   {
-    const auto reset = storage_.data();
-    const auto last = reset + std::ssize(storage_);
-    return const_iterator{std::next(std::addressof(back())), last, reset};
+    return end();
   }
   
   /**
@@ -336,7 +541,7 @@ public:
   constexpr reference push(const value_type& value) 
   {
     assert(std::cmp_less(size(), Capacity));
-    return storage_[(front_ + size_++) % std::ssize(storage_)] = value;
+    return store(push_index(), value);
   }
   
   /**
@@ -347,7 +552,7 @@ public:
   constexpr reference push(value_type&& value) 
   {
     assert(std::cmp_less(size(), Capacity));
-    return storage_[(front_ + size_++) % std::ssize(storage_)] = std::move(value);
+    return store(push_index(), std::move(value));
   }
   
   /**
@@ -364,11 +569,11 @@ public:
     
     if constexpr (!std::is_trivially_destructible_v<T>) {
       // clear the front by assigning it the default-constructed value
-      front() = T();
+      store(front_index(), T());
     }
     
-    if (++front_ == std::ssize(storage_))
-      front_ = 0;
+    if constexpr (Cursor == queue_cursor::front)
+      cursor_ = wrap(cursor_ + 1);
     --size_;
   }
   
@@ -383,11 +588,161 @@ public:
     pop();
     return push(std::move(value));
   }
+  
+  /**
+   * \brief Pops the first \a count elements off the queue.
+   *
+   * This operation invalidates iterators on this queue.
+   */
+  constexpr void pop_n(size_type count) noexcept
+  {
+    assert(count <= size());
+    
+    const auto n = static_cast<difference_type>(count);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (difference_type i = 0; i < n; ++i)
+        store(wrap(front_cursor() + i), T());
+    }
+    
+    if constexpr (Cursor == queue_cursor::front)
+      cursor_ = wrap(cursor_ + n);
+    size_ -= n;
+  }
+  
+  /**
+   * \brief Pushes the elements of \a values to the end of the queue, in order.
+   *
+   * The elements are copied in at most two contiguous runs.
+   *
+   * This operation invalidates iterators on this queue.
+   */
+  constexpr void push_range(std::span<const value_type> values)
+  {
+    assert(values.size() <= Capacity - size());
+    
+    store_range(wrap(back_cursor()), values);
+    const auto n = static_cast<difference_type>(values.size());
+    if constexpr (Cursor == queue_cursor::back)
+      cursor_ = wrap(cursor_ + n);
+    size_ += n;
+  }
+  
+  /**
+   * \brief Pops `values.size()` elements off the queue and pushes the elements of
+   *        \a values to the end of the queue, in order.
+   *
+   * This is equivalent to calling `pop_and_push` on each element of \a values, so
+   * if \a values holds more elements than the queue, the queue is left holding the
+   * last `size()` elements of \a values.
+   *
+   * This operation invalidates iterators on this queue.
+   */
+  constexpr void pop_and_push_n(std::span<const value_type> values)
+  {
+    assert(!empty() || values.empty());
+    
+    const auto count = std::min(values.size(), size());
+    pop_n(count);
+    push_range(values.last(count));
+  }
 
 private:
-  std::array<T, Capacity + 1 /*SENTINEL*/> storage_;
-  difference_type front_ = 0;
+  static_assert(std::random_access_iterator<iterator>);
+  static_assert(std::random_access_iterator<const_iterator>);
+  
+  static constexpr difference_type storage_size = Capacity + 1;
+  
+  std::array<T, (Capacity + 1 /*SENTINEL*/) * (mirrored ? 2 : 1)> storage_;
+  difference_type cursor_ = 0; ///< The index of the front, or one past the back.
   difference_type size_ = 0;
+  
+  /**
+   * \brief Returns \a index modulo the storage size, for \a index no less than
+   *        `-storage_size`.
+   */
+  [[nodiscard]] static constexpr difference_type wrap(difference_type index) noexcept
+  {
+    if constexpr (std::has_single_bit(static_cast<size_type>(storage_size)))
+      return static_cast<difference_type>(static_cast<size_type>(index) & (storage_size - 1));
+    else
+      return (index + storage_size) % storage_size;
+  }
+  
+  /**
+   * \brief Returns an index congruent to the front, to which offsets are added.
+   */
+  [[nodiscard]] constexpr difference_type front_cursor() const noexcept
+  {
+    if constexpr (Cursor == queue_cursor::front)
+      return cursor_;
+    else
+      return cursor_ - size_;
+  }
+  
+  /**
+   * \brief Returns an index congruent to one past the back, to which offsets are
+   *        added.
+   */
+  [[nodiscard]] constexpr difference_type back_cursor() const noexcept
+  {
+    if constexpr (Cursor == queue_cursor::back)
+      return cursor_;
+    else
+      return cursor_ + size_;
+  }
+  
+  /**
+   * \brief Returns the index of the front.
+   */
+  [[nodiscard]] constexpr difference_type front_index() const noexcept
+  {
+    if constexpr (Cursor == queue_cursor::front)
+      return cursor_;
+    else
+      return wrap(cursor_ - size_);
+  }
+  
+  /**
+   * \brief Assigns \a value to the element at \a index, and to its mirror if any.
+   */
+  template<typename U>
+  constexpr reference store(difference_type index, U&& value)
+  {
+    if constexpr (mirrored)
+      storage_[index + storage_size] = value;
+    return storage_[index] = std::forward<U>(value);
+  }
+  
+  /**
+   * \brief Assigns \a values to the elements starting at \a index, and to their
+   *        mirrors if any.
+   */
+  constexpr void store_range(difference_type index, std::span<const value_type> values)
+  {
+    const auto first = std::min(values.size(), static_cast<size_type>(storage_size - index));
+    const auto rest  = values.size() - first;
+    std::copy_n(values.begin(), first, storage_.begin() + index);
+    std::copy_n(values.begin() + first, rest, storage_.begin());
+    if constexpr (mirrored) {
+      std::copy_n(values.begin(), first, storage_.begin() + index + storage_size);
+      std::copy_n(values.begin() + first, rest, storage_.begin() + storage_size);
+    }
+  }
+  
+  /**
+   * \brief Grows the queue by one element and returns the index of the new back.
+   */
+  constexpr difference_type push_index() noexcept
+  {
+    ++size_;
+    if constexpr (Cursor == queue_cursor::back) {
+      const auto index = cursor_;
+      cursor_ = wrap(cursor_ + 1);
+      return index;
+    } else {
+      return wrap(cursor_ + size_ - 1);
+    }
+  }
 };
 
 }
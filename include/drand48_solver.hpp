@@ -0,0 +1,274 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_DRAND48_SOLVER_HPP
+#define PREDICTING_RANDOM_DRAND48_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// DRAND48 SOLVER EXPLANATION
+//
+// The glibc drand48() family shares the 48-bit LCG
+//  X_{i+1} := a * X_{i} + c (mod 2^48), a = 0x5DEECE66D, c = 0xB,
+// and returns, from the new state,
+//  * drand48(), erand48(): X * 2^-48, which exposes the entire state;
+//  * lrand48(), nrand48(): X >> 17; and,
+//  * mrand48(), jrand48(): X >> 16, as a signed 32-bit value.
+//
+// For the truncated outputs, write X_{i} = H * 2^k + L, where H is observed and the
+// low k bits L are hidden. Then
+//  X_{i+1} >> k = a * H + f(L) (mod 2^(48-k)), f(L) = floor((a * L + c) / 2^k),
+// and f is strictly increasing, with steps of about a / 2^k > 2^17. The next output
+// therefore determines f(L) up to the multiple of 2^(48-k) that was reduced, of
+// which there are only a / 2^(48-k) (at most 12), and each determines L through a
+// single division. The candidates are then filtered by further output, so the
+// state is usually recovered from two outputs without any enumeration.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstdint>
+
+#include <array>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace predicting_random
+{
+
+/**
+ * \brief A generator which produces output equivalent to the glibc `drand48()`
+ *        family, using the default multiplier and increment.
+ *
+ * Invoking the generator is equivalent to `lrand48()`, and this type satisfies
+ * the concept `std::uniform_random_bit_generator`.
+ */
+class drand48_generator
+{
+public:
+  using result_type = std::uint32_t;
+  using state_type  = std::uint64_t;
+
+  static constexpr state_type multiplier = 0x5'DEEC'E66Du;
+  static constexpr state_type increment  = 0xBu;
+  static constexpr state_type state_mask = (state_type(1) << 48) - 1u; ///< The state bits.
+
+  static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+  static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max() >> 1; }
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Initializes the generator directly to the 48-bit \a state.
+   */
+  explicit constexpr drand48_generator(state_type state) noexcept : state_(state & state_mask) {}
+
+  /**
+   * \brief Returns a generator initialized as by `srand48(seed)`.
+   */
+  [[nodiscard]] static constexpr drand48_generator from_seed(long seed) noexcept
+  {
+    return drand48_generator{(static_cast<state_type>(seed) & 0xFFFF'FFFFu) << 16 | 0x330Eu};
+  }
+
+  /**
+   * \brief Returns a generator initialized from the state array \a xsubi used by
+   *        `erand48()`, `nrand48()` and `jrand48()`, or set by `seed48()`.
+   */
+  [[nodiscard]] static constexpr drand48_generator from_xsubi(const std::array<std::uint16_t, 3>& xsubi) noexcept
+  {
+    return drand48_generator{state_type(xsubi[0]) | state_type(xsubi[1]) << 16 | state_type(xsubi[2]) << 32};
+  }
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const drand48_generator&, const drand48_generator&) = default;
+
+  /**
+   * \brief Returns the current 48-bit state.
+   */
+  [[nodiscard]] constexpr state_type state() const noexcept { return state_; }
+
+  /**
+   * \brief Returns the current state as the array `xsubi` used by `erand48()`.
+   */
+  [[nodiscard]] constexpr std::array<std::uint16_t, 3> xsubi() const noexcept
+  {
+    return {
+      static_cast<std::uint16_t>(state_),
+      static_cast<std::uint16_t>(state_ >> 16),
+      static_cast<std::uint16_t>(state_ >> 32)};
+  }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Advances the state by one step and returns the new state.
+   */
+  constexpr state_type step() noexcept { return state_ = (multiplier * state_ + increment) & state_mask; }
+
+  /**
+   * \brief Equivalent to `lrand48()`, returning a value in `[0, 2^31)`.
+   */
+  constexpr result_type lrand48() noexcept { return static_cast<result_type>(step() >> 17); }
+
+  /**
+   * \brief Equivalent to `mrand48()`, returning a value in `[-2^31, 2^31)`.
+   */
+  constexpr std::int32_t mrand48() noexcept { return static_cast<std::int32_t>(static_cast<std::uint32_t>(step() >> 16)); }
+
+  /**
+   * \brief Equivalent to `drand48()`, returning a value in `[0, 1)`.
+   */
+  constexpr double drand48() noexcept { return static_cast<double>(step()) / 281474976710656.0; }
+
+  /**
+   * \brief Generates a pseudo-random value as by `lrand48()`.
+   */
+  constexpr result_type operator()() noexcept { return lrand48(); }
+
+private:
+  state_type state_;
+};
+
+/**
+ * \brief The truncated output observed by #drand48_solver.
+ */
+enum class drand48_output
+{
+  lrand48, ///< `lrand48()` or `nrand48()`, exposing the high 31 bits.
+  mrand48, ///< `mrand48()` or `jrand48()`, exposing the high 32 bits.
+};
+
+/**
+ * \brief A solver for #drand48_generator.
+ */
+class drand48_solver
+{
+public:
+  using generator_type = drand48_generator; ///< The targeted generator type.
+  using state_type = typename generator_type::state_type;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed the given \a kind of
+   *        output.
+   */
+  explicit constexpr drand48_solver(drand48_output kind = drand48_output::lrand48) noexcept
+    : shift(kind == drand48_output::lrand48 ? 17 : 16) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the states, after the last output, consistent with the output
+   *        fed so far.
+   *
+   * The list is empty until two outputs have been fed.
+   */
+  [[nodiscard]] const std::vector<state_type>& candidates() const noexcept { return states; }
+
+  /**
+   * \brief Returns the generator that produced the `drand48()` or `erand48()`
+   *        output \a value, positioned after it.
+   *
+   * \return The generator, or \c std::nullopt if \a value is not such an output.
+   */
+  [[nodiscard]] static std::optional<generator_type> from_double(double value) noexcept;
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value of the kind given on construction; for
+   *        `mrand48()`, the value may be passed either signed or unsigned.
+   *
+   * \return A generator positioned after the output, once a single candidate
+   *         state remains.
+   */
+  [[nodiscard]] std::optional<generator_type> feed(std::uint32_t value);
+
+private:
+  int shift;                      ///< The number of hidden low bits.
+  std::optional<std::uint32_t> first;
+  std::vector<state_type> states; ///< Candidate states after the last output.
+
+  /**
+   * \brief Returns the states after \a next that produce \a current and then
+   *        \a next.
+   */
+  [[nodiscard]] std::vector<state_type> solve_pair(std::uint32_t current, std::uint32_t next) const;
+};
+
+inline auto drand48_solver::from_double(double value) noexcept -> std::optional<generator_type>
+{
+  if (!(0.0 <= value && value < 1.0))
+    return std::nullopt;
+
+  const double scaled = value * 281474976710656.0; // exact, as a power of two
+  const auto state = static_cast<state_type>(scaled);
+  if (static_cast<double>(state) != scaled)
+    return std::nullopt;
+
+  return generator_type{state};
+}
+
+inline auto drand48_solver::solve_pair(std::uint32_t current, std::uint32_t next) const
+  -> std::vector<state_type>
+{
+  constexpr auto a = generator_type::multiplier;
+  constexpr auto c = generator_type::increment;
+  const int observed_bits = 48 - shift;
+  const state_type observed_mask = (state_type(1) << observed_bits) - 1u;
+  const state_type low_count = state_type(1) << shift;
+
+  const state_type high = current;
+  const state_type target = (next - a * high) & observed_mask;
+  const auto f = [&](state_type low) { return (a * low + c) >> shift; };
+
+  std::vector<state_type> result;
+  for (state_type reduced = target; reduced <= f(low_count - 1); reduced += observed_mask + 1) {
+    // the smallest low with f(low) >= reduced, which is the only candidate
+    const state_type bound = reduced << shift;
+    const state_type low = bound <= c ? 0 : (bound - c + a - 1) / a;
+    if (low < low_count && f(low) == reduced)
+      result.push_back((a * (high << shift | low) + c) & generator_type::state_mask);
+  }
+
+  return result;
+}
+
+inline auto drand48_solver::feed(std::uint32_t value) -> std::optional<generator_type>
+{
+  assert(shift == 16 || value <= generator_type::max());
+
+  if (!first) {
+    first = value;
+    return std::nullopt;
+  }
+
+  if (states.empty()) {
+    states = solve_pair(*first, value);
+  } else {
+    std::erase_if(states, [this, value](state_type& state) {
+      state = (generator_type::multiplier * state + generator_type::increment) & generator_type::state_mask;
+      return (state >> shift) != value;
+    });
+  }
+
+  assert(!states.empty());
+  if (states.size() != 1)
+    return std::nullopt;
+
+  return generator_type{states.front()};
+}
+
+}
+
+#endif // PREDICTING_RANDOM_DRAND48_SOLVER_HPP
@@ -0,0 +1,325 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_EVENT_PREDICTOR_HPP
+#define PREDICTING_RANDOM_EVENT_PREDICTOR_HPP
+
+// ---------------------------------------------------------------------------------
+// EVENT PREDICTOR EXPLANATION
+//
+// Applications rarely use the output of random() directly. An event (a die roll, a
+// card drawn, a deck shuffled) consumes a fixed number of calls, each mapped into
+// a range. A consumption pattern describes one event as a type, much as an
+// observation model does (see observation_model.hpp); for example
+//  event_pattern<consumption::mod<6>, consumption::mod<52>>
+// consumes two calls per event and maps them as `random() % 6` and
+// `random() % 52`. event_predictor then predicts such events from a solved
+// generator, in bulk.
+//
+// Unlike observation models, consumption stages only map output forward, so any
+// mapping can be predicted, whether or not a solver supports observing it.
+//
+// IMPLEMENTATION NOTES
+// The outputs of a block of events are generated first, contiguously, and then
+// mapped, so that generation and mapping each run as a tight loop. Divisors known
+// at compile time are reduced by the compiler to a multiplication and a shift.
+// Shuffles divide by a different value for each call, so the multipliers and shifts
+// for their divisors are computed ahead of time by fixed_divisor.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <numeric>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "prng.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief A divisor of the output of #reference_generator, by which division is
+ *        performed as a multiplication and a shift.
+ */
+class fixed_divisor
+{
+public:
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to the divisor \a divisor.
+   */
+  explicit constexpr fixed_divisor(std::uint32_t divisor) noexcept
+    : divisor_(divisor), shift(31 + std::bit_width(divisor - 1u))
+  {
+    assert(divisor > 0);
+
+    // ceil(2^shift / divisor) is exact for 31-bit dividends, and is below 2^32
+    multiplier = ((std::uint64_t(1) << shift) + divisor - 1u) / divisor;
+  }
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the divisor.
+   */
+  [[nodiscard]] constexpr std::uint32_t divisor() const noexcept { return divisor_; }
+
+  /**
+   * \brief Returns `value / divisor()`, for \a value less than `2^31`.
+   */
+  [[nodiscard]] constexpr std::uint32_t divide(std::uint32_t value) const noexcept
+  {
+    assert(value < (std::uint32_t(1) << 31));
+    return static_cast<std::uint32_t>((value * multiplier) >> shift);
+  }
+
+  /**
+   * \brief Returns `value % divisor()`, for \a value less than `2^31`.
+   */
+  [[nodiscard]] constexpr std::uint32_t remainder(std::uint32_t value) const noexcept
+  {
+    return value - divide(value) * divisor_;
+  }
+
+private:
+  std::uint32_t divisor_;
+  int           shift;
+  std::uint64_t multiplier = 0;
+};
+
+namespace consumption
+{
+
+/**
+ * \brief Specifies a stage of an event, which consumes `Stage::calls` consecutive
+ *        outputs and maps them to a value.
+ */
+template<typename Stage>
+concept stage = requires (const std::uint32_t* outputs)
+{
+  typename Stage::value_type;
+  requires std::same_as<decltype(Stage::calls), const std::size_t>;
+  { Stage::map(outputs) } -> std::same_as<typename Stage::value_type>;
+};
+
+/**
+ * \brief Consumes one call, as by `random()`.
+ */
+struct exact
+{
+  using value_type = std::uint32_t;
+  static constexpr std::size_t calls = 1;
+
+  [[nodiscard]] static constexpr value_type map(const std::uint32_t* outputs) noexcept { return outputs[0]; }
+};
+
+/**
+ * \brief Consumes one call, as by `random() % N`.
+ */
+template<std::uint32_t N>
+  requires (N > 0)
+struct mod
+{
+  using value_type = std::uint32_t;
+  static constexpr std::size_t calls = 1;
+
+  [[nodiscard]] static constexpr value_type map(const std::uint32_t* outputs) noexcept { return outputs[0] % N; }
+};
+
+/**
+ * \brief Consumes one call, as by `random() >> Bits`.
+ */
+template<int Bits>
+  requires (0 <= Bits && Bits < 31)
+struct shift
+{
+  using value_type = std::uint32_t;
+  static constexpr std::size_t calls = 1;
+
+  [[nodiscard]] static constexpr value_type map(const std::uint32_t* outputs) noexcept { return outputs[0] >> Bits; }
+};
+
+/**
+ * \brief Consumes one call, as by `random() / (RAND_MAX + 1.0) * Range`, rounded
+ *        down.
+ */
+template<std::uint32_t Range>
+  requires (Range > 0)
+struct scale
+{
+  using value_type = std::uint32_t;
+  static constexpr std::size_t calls = 1;
+
+  [[nodiscard]] static constexpr value_type map(const std::uint32_t* outputs) noexcept
+  {
+    return static_cast<value_type>((outputs[0] * std::uint64_t(Range)) >> 31);
+  }
+};
+
+/**
+ * \brief Consumes `N - 1` calls to shuffle `0, 1, ..., N - 1`, as by the
+ *        Fisher-Yates shuffle
+ * \code
+ *  for (i = N - 1; i > 0; --i)
+ *    swap(a[i], a[random() % (i + 1)]);
+ * \endcode
+ */
+template<std::size_t N>
+  requires (2 <= N && N <= 65536)
+struct shuffle
+{
+  using index_type = std::conditional_t<(N <= 256), std::uint8_t, std::uint16_t>;
+  using value_type = std::array<index_type, N>;
+  static constexpr std::size_t calls = N - 1;
+
+  [[nodiscard]] static constexpr value_type map(const std::uint32_t* outputs) noexcept
+  {
+    value_type result;
+    std::iota(result.begin(), result.end(), index_type(0));
+    for (std::size_t k = 0; k < calls; ++k) {
+      const std::size_t i = N - 1 - k;
+      std::swap(result[i], result[divisors[k].remainder(outputs[k])]);
+    }
+    return result;
+  }
+
+private:
+  /**
+   * \brief The divisor of the `k`-th call, `N - k`.
+   */
+  static constexpr auto divisors = []<std::size_t... K>(std::index_sequence<K...>) {
+    return std::array<fixed_divisor, calls>{fixed_divisor(static_cast<std::uint32_t>(N - K))...};
+  }(std::make_index_sequence<calls>{});
+};
+
+}
+
+/**
+ * \brief Describes an event which consumes the calls of \a Stages in order.
+ */
+template<consumption::stage... Stages>
+  requires (sizeof...(Stages) > 0)
+struct event_pattern
+{
+  using event_type = std::tuple<typename Stages::value_type...>;
+
+  /**
+   * \brief The number of calls consumed by each event.
+   */
+  static constexpr std::size_t calls = (Stages::calls + ...);
+
+  /**
+   * \brief Maps the #calls consecutive \a outputs of an event to the event.
+   */
+  [[nodiscard]] static constexpr event_type map(const std::uint32_t* outputs) noexcept
+  {
+    return map(outputs, std::index_sequence_for<Stages...>{});
+  }
+
+private:
+  /**
+   * \brief The offset of the outputs of each stage within an event.
+   */
+  static constexpr auto offsets = [] {
+    std::array<std::size_t, sizeof...(Stages)> result{};
+    constexpr std::array<std::size_t, sizeof...(Stages)> sizes{Stages::calls...};
+    std::exclusive_scan(sizes.begin(), sizes.end(), result.begin(), std::size_t(0));
+    return result;
+  }();
+
+  template<std::size_t... I>
+  [[nodiscard]] static constexpr event_type map(const std::uint32_t* outputs, std::index_sequence<I...>) noexcept
+  {
+    return event_type{std::tuple_element_t<I, std::tuple<Stages...>>::map(outputs + offsets[I])...};
+  }
+};
+
+/**
+ * \brief Predicts the events described by \a Pattern from a solved generator.
+ */
+template<typename Pattern>
+class event_predictor
+{
+public:
+  using pattern_type   = Pattern;
+  using event_type     = typename Pattern::event_type;
+  using generator_type = basic_reference_generator<sliding_window_backend<>>;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a predictor of the events following the current state of
+   *        \a gen.
+   */
+  template<typename Backend>
+  explicit constexpr event_predictor(const basic_reference_generator<Backend>& gen) noexcept
+    : gen(gen) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the generator, positioned after the events predicted so far.
+   */
+  [[nodiscard]] constexpr const generator_type& generator() const noexcept { return gen; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Predicts the next event.
+   */
+  constexpr event_type next() noexcept
+  {
+    std::array<std::uint32_t, Pattern::calls> outputs;
+    for (auto& value : outputs)
+      value = gen();
+    return Pattern::map(outputs.data());
+  }
+
+  /**
+   * \brief Predicts the next `events.size()` events into \a events.
+   */
+  constexpr void predict(std::span<event_type> events) noexcept
+  {
+    while (!events.empty()) {
+      const std::size_t count = std::min(block_events, events.size());
+      for (std::size_t i = 0; i < count * Pattern::calls; ++i)
+        outputs[i] = gen();
+
+      const std::uint32_t* event_outputs = outputs.data();
+      for (std::size_t e = 0; e < count; ++e, event_outputs += Pattern::calls)
+        events[e] = Pattern::map(event_outputs);
+
+      events = events.subspan(count);
+    }
+  }
+
+private:
+  /**
+   * \brief The number of events whose outputs are generated at a time.
+   */
+  static constexpr std::size_t block_events = std::max<std::size_t>(1, 4096 / Pattern::calls);
+
+  generator_type gen;
+  std::array<std::uint32_t, block_events * Pattern::calls> outputs;
+};
+
+}
+
+#endif // PREDICTING_RANDOM_EVENT_PREDICTOR_HPP
@@ -0,0 +1,238 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_GF2_MATRIX_HPP
+#define PREDICTING_RANDOM_GF2_MATRIX_HPP
+
+// ---------------------------------------------------------------------------------
+// GF(2) MATRIX EXPLANATION
+//
+// semicanonical_matrix (see solver.hpp) eliminates each row as it is pushed, which
+// costs a pass over every pivot per row. This is fine for 32 or 64 unknowns, but
+// generators with hundreds of lags need hundreds of unknowns, and the cost then
+// grows with the cube of the lag.
+//
+// gf2_matrix instead collects rows and brings them to reduced row echelon form on
+// request, by the Method of Four Russians (M4RI). Columns are processed in blocks
+// of 8. For each block, up to 8 pivot rows are found and reduced against each
+// other, and a table of all 256 combinations of them is built, indexed by the bits
+// of a row in the block. Every other row then clears the whole block with a single
+// lookup and XOR, rather than one XOR per pivot.
+//
+// IMPLEMENTATION NOTES
+// Rows are stored contiguously, so each block is a single sweep over memory. The
+// table holds 256 rows and stays in L1 for the few hundred columns of interest,
+// while the rows stream past it. Rows that become zero are discarded and the pivot
+// rows are kept, so when elimination is repeated as further rows are collected, the
+// new rows are first reduced against the existing pivot rows, and only the blocks
+// in which they introduce pivots are swept.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#include <vector>
+
+namespace predicting_random
+{
+
+/**
+ * \brief A matrix over GF(2) with \a Columns columns and any number of rows, which
+ *        is brought to reduced row echelon form by #eliminate.
+ */
+template<std::size_t Columns>
+  requires (Columns > 0)
+class gf2_matrix
+{
+public:
+  static constexpr std::size_t columns    = Columns;
+  static constexpr std::size_t words      = (Columns + 63) / 64; ///< Words per row.
+  static constexpr std::size_t block_bits = 8;                   ///< Columns per M4RI block.
+
+  using row_type = std::array<std::uint64_t, words>; ///< Columns from the LSB of the first word.
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a matrix without rows.
+   */
+  gf2_matrix() = default;
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the number of rows.
+   */
+  [[nodiscard]] std::size_t rows() const noexcept { return data.size() / words; }
+
+  /**
+   * \brief Returns the rank found by the last call to #eliminate.
+   */
+  [[nodiscard]] std::size_t rank() const noexcept { return pivots.size(); }
+
+  /**
+   * \brief Returns the row at \a index.
+   */
+  [[nodiscard]] std::span<const std::uint64_t, words> operator[](std::size_t index) const noexcept
+  {
+    return std::span<const std::uint64_t, words>(data.data() + index * words, words);
+  }
+
+  /**
+   * \brief Returns the pivot column of the row at \a index, which must be less
+   *        than #rank.
+   */
+  [[nodiscard]] std::size_t pivot(std::size_t index) const noexcept { return pivots[index]; }
+
+  /**
+   * \brief Returns the element of the row at \a index in \a column.
+   */
+  [[nodiscard]] bool test(std::size_t index, std::size_t column) const noexcept
+  {
+    return (data[index * words + column / 64] >> (column % 64)) & 1u;
+  }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Appends \a row to the matrix.
+   */
+  void push_row(const row_type& row) { data.insert(data.end(), row.begin(), row.end()); }
+
+  /**
+   * \brief Brings the matrix to reduced row echelon form, pivoting only on the
+   *        first \a pivot_columns columns, and discards rows that become zero in
+   *        those columns.
+   *
+   * Afterwards, the rows at indices less than #rank are the pivot rows. Rows pushed
+   * since the last call are reduced against these before any block is swept, so
+   * repeated calls only pay for the blocks that gain pivots. \a pivot_columns
+   * must not change between calls.
+   *
+   * \return The rank of the first \a pivot_columns columns.
+   */
+  std::size_t eliminate(std::size_t pivot_columns = Columns);
+
+private:
+  std::vector<std::uint64_t> data;   ///< The rows, each #words long.
+  std::vector<std::size_t>   pivots; ///< The pivot column of each pivot row.
+  std::vector<std::uint64_t> table;  ///< Combinations of the pivot rows of a block.
+
+  std::uint64_t* row_data(std::size_t index) noexcept { return data.data() + index * words; }
+  const std::uint64_t* row_data(std::size_t index) const noexcept { return data.data() + index * words; }
+
+  static void xor_row(std::uint64_t* dst, const std::uint64_t* src) noexcept
+  {
+    for (std::size_t w = 0; w < words; ++w)
+      dst[w] ^= src[w];
+  }
+
+  /**
+   * \brief Returns the bits of \a row in the block starting at \a column.
+   */
+  static std::uint32_t block_of(const std::uint64_t* row, std::size_t column) noexcept
+  {
+    static_assert(64 % block_bits == 0);
+    return (row[column / 64] >> (column % 64)) & ((1u << block_bits) - 1u);
+  }
+};
+
+template<std::size_t Columns>
+  requires (Columns > 0)
+std::size_t gf2_matrix<Columns>::eliminate(std::size_t pivot_columns)
+{
+  assert(pivot_columns <= Columns);
+
+  const std::size_t n = rows();
+  std::size_t r = rank(); // rows [0, r) are pivot rows
+  table.resize((std::size_t(1) << block_bits) * words);
+
+  // reduce the rows pushed since the last call against the existing pivot rows,
+  // streaming each pivot row once over the (usually few) new rows
+  for (std::size_t i = 0; i < r; ++i) {
+    const std::uint64_t* pivot_row = row_data(i);
+    const std::size_t column = pivots[i];
+    for (std::size_t j = r; j < n; ++j) {
+      std::uint64_t* row = row_data(j);
+      if ((row[column / 64] >> (column % 64)) & 1u)
+        xor_row(row, pivot_row);
+    }
+  }
+
+  for (std::size_t c = 0; c < pivot_columns && r < n; c += block_bits) {
+    const std::size_t width = std::min(block_bits, pivot_columns - c);
+    const std::uint32_t block_mask = (1u << width) - 1u;
+
+    // find the pivot rows of the block, reduced against each other
+    std::array<std::size_t, block_bits> block_pivots;
+    std::size_t k = 0;
+    for (std::size_t i = r; i < n && k < width; ++i) {
+      std::uint64_t* row = row_data(i);
+      for (std::size_t j = 0; j < k; ++j) {
+        if ((block_of(row, c) >> (block_pivots[j] - c)) & 1u)
+          xor_row(row, row_data(r + j));
+      }
+
+      const std::uint32_t bits = block_of(row, c) & block_mask;
+      if (bits == 0)
+        continue;
+
+      const std::size_t column = c + std::countr_zero(bits);
+      std::swap_ranges(row, row + words, row_data(r + k));
+      row = row_data(r + k);
+      for (std::size_t j = 0; j < k; ++j) {
+        if ((block_of(row_data(r + j), c) >> (column - c)) & 1u)
+          xor_row(row_data(r + j), row);
+      }
+      block_pivots[k++] = column;
+    }
+
+    if (k == 0)
+      continue;
+
+    // table[bits] clears the pivot columns selected by bits
+    std::array<const std::uint64_t*, block_bits> by_offset{};
+    for (std::size_t j = 0; j < k; ++j)
+      by_offset[block_pivots[j] - c] = row_data(r + j);
+
+    std::fill_n(table.begin(), words, 0u);
+    for (std::uint32_t bits = 1; bits < (1u << block_bits); ++bits) {
+      std::uint64_t* entry = table.data() + bits * words;
+      const std::uint64_t* rest = table.data() + (bits & (bits - 1u)) * words;
+      std::copy_n(rest, words, entry);
+      if (const auto* pivot_row = by_offset[std::countr_zero(bits)])
+        xor_row(entry, pivot_row);
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (i == r)
+        i += k; // skip the pivot rows of this block
+      if (i >= n)
+        break;
+
+      std::uint64_t* row = row_data(i);
+      if (const auto bits = block_of(row, c))
+        xor_row(row, table.data() + bits * words);
+    }
+
+    pivots.insert(pivots.end(), block_pivots.begin(), block_pivots.begin() + k);
+    r += k;
+  }
+
+  data.resize(r * words); // the remaining rows are zero in the pivot columns
+  return r;
+}
+
+}
+
+#endif // PREDICTING_RANDOM_GF2_MATRIX_HPP
@@ -0,0 +1,349 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_HIDDEN_STATE_LATTICE_HPP
+#define PREDICTING_RANDOM_HIDDEN_STATE_LATTICE_HPP
+
+// ---------------------------------------------------------------------------------
+// HIDDEN STATE LATTICE EXPLANATION
+//
+// Several solvers observe only part of each internal state (see solver.hpp), such
+// that each state can be written as
+//  x_{i} = b_{i} + S * y_{i}, 0 <= y_{i} < w_{i},
+// where b_{i}, w_{i} and the common scale S = 2^a * q (q odd) are known and y_{i}
+// is hidden.
+//
+// The recurrence is linear over Z/2^32, so any later state is a linear
+// combination of the 31 states in a window:
+//  x_{n} = Sum[c_{n,j} * x_{j}, {j in [0 .. 30]}] (mod 2^B),
+// where c_{n,j} are the coefficients of X^n mod (X^31 - X^28 - 1) and B = 32.
+// Substituting and dividing through by S gives
+//  y_{n} = Sum[c_{n,j} * y_{j}, {j in [0 .. 30]}] + d_{n} (mod 2^(B-a)),
+// with d_{n} known. Solvers which know every carry out of the recurrence (see
+// modular_solver.hpp) have the relation over the integers instead, and may take a
+// larger B, with any known offsets folded into b_{n}. The vector of hidden values (y_{j} for the window, y_{n} for
+// some later steps n) is therefore a point of a known lattice, shifted by a known
+// offset, with unusually small coordinates. It is recovered by embedding the offset
+// into the lattice basis (Kannan's embedding) and reducing the basis with LLL; the
+// hidden values then appear as a short basis vector.
+//
+// Two properties of the recurrence shape the choice of steps n:
+//  * for small n, c_{n,j} are small non-negative integers and the relation holds
+//    over the integers, which introduces short vectors unrelated to the output;
+//    the steps must be far enough from the window that the coefficients have
+//    wrapped (roughly 1000 steps for B = 32, growing in proportion to B); and,
+//  * if n - 31, n - 3 and n are all used, the third adds no information, so the
+//    steps are taken in blocks of fewer than 31 consecutive outputs, separated by
+//    the same gap.
+//
+// Each step n contributes about (B - a) - log2(w) bits of information, and the
+// window hides 31 * log2(w) bits, which determines the number of steps needed.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "lattice_reduction.hpp"
+#include "prng.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief The known parts of an internal state `x = base + scale * y`, where the
+ *        hidden value `y` lies in `[0, width)`.
+ */
+struct hidden_state
+{
+  std::uint64_t base;  ///< The known offset of the state, modulo `2^relation_bits`.
+  std::uint64_t width; ///< The number of possible hidden values.
+};
+
+/**
+ * \brief Reconstructs a window of 31 internal states from partial knowledge of
+ *        those states and of later states, using lattice reduction.
+ *
+ * Observations are addressed by their offset from the start of the window; the
+ * offsets that are used are given by #equation_offset.
+ */
+class hidden_state_lattice
+{
+public:
+  using table_type = reference_generator::table_type;
+
+  static constexpr std::size_t window_size = 31;   ///< Size of the unknown window.
+  static constexpr std::size_t block_size  = 28;   ///< Consecutive equations per block.
+  static constexpr std::size_t margin      = 8;    ///< Equations beyond the estimate.
+
+  /**
+   * \brief The largest lattice dimension considered practical to reduce.
+   */
+  static constexpr std::size_t max_dimension = 256;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a lattice for states `x = base + scale * y`, where the
+   *        widest hidden value has \a max_width possibilities and the recurrence
+   *        holds modulo `2^relation_bits`.
+   *
+   * \a relation_bits may only exceed `32` if the recurrence holds over the
+   * integers, such that it holds for any modulus; the scale must then leave at most
+   * `62` bits of the modulus.
+   */
+  constexpr hidden_state_lattice(std::uint64_t max_width, std::uint32_t scale = 1, int relation_bits = 32) noexcept
+    : scale_(scale), relation_bits_(relation_bits), max_width_(max_width)
+  {
+    assert(scale != 0 && max_width >= 1);
+    assert(32 <= relation_bits && relation_bits <= 64 && modulus_bits() <= 62);
+  }
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the number of bits of the hidden value equations are taken over.
+   */
+  [[nodiscard]] constexpr int modulus_bits() const noexcept { return relation_bits_ - std::countr_zero(scale_); }
+
+  /**
+   * \brief Returns the number of equations used, beyond the window.
+   */
+  [[nodiscard]] constexpr std::size_t equation_count() const noexcept
+  {
+    // the hidden vector must be shorter than the other short lattice vectors by a
+    // gap that LLL can resolve, which grows with the dimension (about 1.02^d)
+    const double width_bits = log2(max_width_);
+    std::size_t equations = margin;
+    for (int i = 0; i < 4; ++i) {
+      const double hidden = width_bits + 1.0 + 0.025 * static_cast<double>(window_size + equations);
+      const double information = modulus_bits() - hidden;
+      if (information <= 0.5)
+        return max_dimension; // impractical, see practical()
+
+      const double estimate = window_size * hidden / information;
+      equations = static_cast<std::size_t>(estimate) + margin;
+      if (static_cast<double>(static_cast<std::size_t>(estimate)) < estimate)
+        ++equations;
+    }
+
+    return equations;
+  }
+  
+  /**
+   * \brief Returns \c true if the lattice is small enough to be reduced in
+   *        practice.
+   */
+  [[nodiscard]] constexpr bool practical() const noexcept { return window_size + equation_count() < max_dimension; }
+
+  /**
+   * \brief Returns the number of steps between blocks of equations, which is long
+   *        enough for the coefficients to wrap the modulus of the relation.
+   */
+  [[nodiscard]] constexpr std::size_t block_gap() const noexcept { return 1000 * static_cast<std::size_t>(relation_bits_) / 32; }
+
+  /**
+   * \brief Returns the offset, relative to the window, of the equation \a index.
+   */
+  [[nodiscard]] constexpr std::size_t equation_offset(std::size_t index) const noexcept
+  {
+    return window_size + block_gap() + (index / block_size) * (block_gap() + block_size) + index % block_size;
+  }
+
+  /**
+   * \brief Returns the number of observations spanned from the start of the window
+   *        to the last equation.
+   */
+  [[nodiscard]] constexpr std::size_t span() const noexcept { return equation_offset(equation_count() - 1) + 1; }
+
+  /**
+   * \brief Returns the windows of states consistent with the lattice.
+   *
+   * \param [in] state_at Returns the #hidden_state at a given offset from the start
+   *                      of the window.
+   * \param [in] stop     Requests that the reduction be abandoned.
+   *
+   * \return The candidate windows, ordered from oldest to most recent state. Each
+   *         candidate must still be verified against the observations.
+   */
+  template<typename StateAt>
+  [[nodiscard]] std::vector<table_type> candidates(StateAt&& state_at, std::stop_token stop = {}) const;
+
+private:
+  std::uint32_t scale_;
+  int relation_bits_;
+  std::uint64_t max_width_;
+
+  /**
+   * \brief Returns the binary logarithm of \a value, which must be positive.
+   *
+   * Unlike `std::log2`, this may be evaluated at compile time, so that the moduli
+   * and widths for which the lattice is impractical can be rejected then.
+   */
+  [[nodiscard]] static constexpr double log2(std::uint64_t value) noexcept
+  {
+    // the integer part is the position of the top bit; each squaring of the
+    // mantissa in [1, 2) then shifts out the next bit of the fractional part
+    const int exponent = std::bit_width(value) - 1;
+    double mantissa = static_cast<double>(value) / static_cast<double>(std::uint64_t(1) << exponent);
+    double result = exponent;
+    for (double bit = 0.5; bit > 0x1p-52; bit /= 2) {
+      mantissa *= mantissa;
+      if (mantissa >= 2.0) {
+        mantissa /= 2.0;
+        result += bit;
+      }
+    }
+    return result;
+  }
+};
+
+/**
+ * \brief Runs `attempt(i, stop)` for each `i` in `[0, count)` concurrently and
+ *        returns the first result that is not \c std::nullopt.
+ *
+ * Once a result is found, the remaining attempts are asked to stop through their
+ * `std::stop_token`.
+ */
+template<typename Result, typename Attempt>
+[[nodiscard]] std::optional<Result> first_success(std::size_t count, Attempt&& attempt)
+{
+  std::mutex result_mutex;
+  std::optional<Result> result;
+  std::stop_source stop;
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t i = 0; i < count; ++i) {
+      workers.emplace_back([&, i] {
+        std::optional<Result> candidate = attempt(i, stop.get_token());
+        if (!candidate)
+          return;
+
+        std::scoped_lock lock(result_mutex);
+        if (!result)
+          result = std::move(candidate);
+        stop.request_stop();
+      });
+    }
+  }
+
+  return result;
+}
+
+template<typename StateAt>
+auto hidden_state_lattice::candidates(StateAt&& state_at, std::stop_token stop) const
+  -> std::vector<table_type>
+{
+  const auto equations = equation_count();
+  const auto dimension = window_size + equations;
+
+  const int shift = std::countr_zero(scale_);
+  const std::uint64_t relation_mask = ~std::uint64_t(0) >> (64 - relation_bits_);
+  const std::uint64_t modulus_mask = relation_mask >> shift;
+
+  // inverse of the odd part of the scale, modulo 2^64 (Newton's iteration)
+  const std::uint64_t odd = scale_ >> shift;
+  std::uint64_t odd_inverse = odd;
+  for (int i = 0; i < 6; ++i)
+    odd_inverse *= 2 - odd * odd_inverse;
+
+  std::vector<hidden_state> states(dimension);
+  for (std::size_t i = 0; i < window_size; ++i)
+    states[i] = state_at(i);
+  for (std::size_t i = 0; i < equations; ++i)
+    states[window_size + i] = state_at(equation_offset(i));
+
+  // coefficients of X^n mod (X^31 - X^28 - 1), for each equation offset n
+  std::vector<std::array<std::uint64_t, window_size>> coefficients(equations);
+  {
+    std::array<std::uint64_t, window_size> poly{/*ZERO*/};
+    poly[window_size - 1] = 1; // X^30
+    for (std::size_t n = window_size, i = 0; i < equations; ++n) {
+      const auto carry = poly[window_size - 1];
+      std::copy_backward(poly.begin(), poly.end() - 1, poly.end());
+      poly[0] = carry;
+      poly[28] += carry;
+
+      if (n == equation_offset(i))
+        coefficients[i++] = poly;
+    }
+  }
+
+  // the hidden values are taken relative to the centers of their ranges
+  std::vector<std::int64_t> centers(dimension);
+  std::int64_t embedding = 1;
+  for (std::size_t i = 0; i < dimension; ++i) {
+    centers[i] = static_cast<std::int64_t>(states[i].width / 2);
+    embedding = std::max(embedding, centers[i]);
+  }
+
+  lattice_basis basis(dimension + 1, std::vector<std::int64_t>(dimension + 1));
+  for (std::size_t j = 0; j < window_size; ++j) {
+    basis[j][j] = 1;
+    for (std::size_t i = 0; i < equations; ++i)
+      basis[j][window_size + i] = static_cast<std::int64_t>(coefficients[i][j] & modulus_mask);
+  }
+
+  for (std::size_t i = 0; i < equations; ++i)
+    basis[window_size + i][window_size + i] = static_cast<std::int64_t>(modulus_mask) + 1;
+
+  auto& target = basis[dimension];
+  for (std::size_t j = 0; j < window_size; ++j)
+    target[j] = centers[j];
+  for (std::size_t i = 0; i < equations; ++i) {
+    std::uint64_t known = -states[window_size + i].base;
+    for (std::size_t j = 0; j < window_size; ++j)
+      known += coefficients[i][j] * states[j].base;
+
+    known &= relation_mask;
+    if (known & ~(~std::uint64_t(0) << shift))
+      return {}; // known parts are inconsistent with the recurrence
+
+    const std::uint64_t offset = ((known >> shift) * odd_inverse) & modulus_mask;
+    target[window_size + i] = centers[window_size + i] - static_cast<std::int64_t>(offset);
+  }
+  target[dimension] = embedding;
+
+  if (!lll_reduce(basis, stop, 0.75L) || !lll_reduce(basis, stop))
+    return {};
+
+  std::vector<table_type> result;
+  for (const auto& row : basis) {
+    if (row[dimension] != embedding && row[dimension] != -embedding)
+      continue;
+
+    // the short vector is (y - centers, -embedding), up to sign
+    const std::int64_t sign = row[dimension] == -embedding ? 1 : -1;
+
+    table_type table;
+    bool feasible = true;
+    for (std::size_t j = 0; feasible && j < window_size; ++j) {
+      const auto hidden = sign * row[j] + centers[j];
+      feasible = 0 <= hidden && static_cast<std::uint64_t>(hidden) < states[j].width;
+      table.push(static_cast<std::uint32_t>(states[j].base + scale_ * static_cast<std::uint64_t>(hidden)));
+    }
+
+    if (feasible)
+      result.push_back(table);
+  }
+
+  return result;
+}
+
+}
+
+#endif // PREDICTING_RANDOM_HIDDEN_STATE_LATTICE_HPP
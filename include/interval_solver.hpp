@@ -0,0 +1,261 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_INTERVAL_SOLVER_HPP
+#define PREDICTING_RANDOM_INTERVAL_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// INTERVAL SOLVER EXPLANATION
+//
+// Applications frequently scale output down to a range, through `random() >> k`
+// or `random() / (RAND_MAX + 1.0) * N`. Each observation then only bounds the
+// output to an interval, which in terms of the internal state (see solver.hpp) is
+//  x_{i} = lo_{i} + u_{i}, 0 <= u_{i} < w_{i},
+// where lo_{i} and w_{i} are known and u_{i} is hidden. No carry events can be
+// observed from the high bits, so the parity system used by solver does not apply.
+//
+// Instead, the recurrence is linear over Z/2^32, which allows the hidden values of
+// a window of states to be recovered through lattice reduction, as described in
+// hidden_state_lattice.hpp.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "hidden_state_lattice.hpp"
+#include "prng.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief Inclusive bounds on a single output of #reference_generator.
+ */
+struct output_interval
+{
+  std::uint32_t lo; ///< The smallest possible output.
+  std::uint32_t hi; ///< The largest possible output.
+
+  friend constexpr bool operator==(const output_interval&, const output_interval&) = default;
+
+  /**
+   * \brief Returns \c true if and only if \a value lies within the interval.
+   */
+  [[nodiscard]] constexpr bool contains(std::uint32_t value) const noexcept { return lo <= value && value <= hi; }
+};
+
+/**
+ * \brief Returns the interval of outputs `o` for which `o >> shift == value`.
+ */
+[[nodiscard]] constexpr output_interval shifted_output(std::uint32_t value, int shift) noexcept
+{
+  assert(0 <= shift && shift < 31);
+  return {.lo = value << shift, .hi = ((value + 1u) << shift) - 1u};
+}
+
+/**
+ * \brief Returns the interval of outputs `o` for which `o * range / 2^31`, rounded
+ *        down, equals \a value.
+ *
+ * This corresponds to the common idiom `random() / (RAND_MAX + 1.0) * range`,
+ * truncated to an integer. The floating-point form may round differently for
+ * outputs within `2^-22` of a boundary when `range` is large; such observations
+ * are rare, and the solver rejects any candidate inconsistent with them.
+ */
+[[nodiscard]] constexpr output_interval scaled_output(std::uint32_t value, std::uint32_t range) noexcept
+{
+  assert(range > 0 && value < range);
+  constexpr std::uint64_t period = std::uint64_t(1) << 31;
+
+  // smallest o such that o * range >= value * 2^31
+  const auto ceil_div = [](std::uint64_t n, std::uint64_t d) { return (n + d - 1) / d; };
+  const auto lo = ceil_div(value * period, range);
+  const auto hi = ceil_div((value + std::uint64_t(1)) * period, range) - 1;
+  return {.lo = static_cast<std::uint32_t>(lo), .hi = static_cast<std::uint32_t>(hi)};
+}
+
+/**
+ * \brief A solver for #reference_generator which only observes an interval
+ *        containing each output.
+ *
+ * Unlike #solver, observations are retained, as the reconstruction works over a
+ * window of roughly a thousand outputs or more. The number of outputs needed grows
+ * with the width of the widest observation, see #required_samples. Once an
+ * observation is too wide for the reconstruction to be practical, the solver is
+ * #impractical and stops retaining observations.
+ */
+class interval_solver
+{
+public:
+  using generator_type = reference_generator; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  interval_solver() = default;
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the number of observations retained by the solver, which is the
+   *        number fed to it unless it is #impractical.
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return observations.size(); }
+
+  /**
+   * \brief Returns \c true if an observation was too wide for the reconstruction to
+   *        be practical, in which case the solver never produces a generator and
+   *        further observations are ignored.
+   */
+  [[nodiscard]] bool impractical() const noexcept { return !lattice().practical(); }
+
+  /**
+   * \brief Returns the lattice used to reconstruct the generator, given the widest
+   *        observation fed so far.
+   */
+  [[nodiscard]] hidden_state_lattice lattice() const noexcept { return hidden_state_lattice{max_width}; }
+
+  /**
+   * \brief Returns the number of observations needed before a reconstruction can be
+   *        attempted, or \c std::nullopt if the observations are too wide for the
+   *        reconstruction to be practical.
+   */
+  [[nodiscard]] std::optional<std::size_t> required_samples() const noexcept;
+
+  /**
+   * \brief Attempts to reconstruct the target generator from the observations so
+   *        far.
+   *
+   * Up to \a threads windows of observations, starting from the most recent, are
+   * tried concurrently; the first consistent reconstruction is returned.
+   *
+   * \param [in] threads The maximum number of concurrent attempts, or `0` to use
+   *                     the number of hardware threads.
+   *
+   * \return A generator positioned after the last observation, or \c std::nullopt
+   *         if no window produced a generator consistent with the observations.
+   */
+  [[nodiscard]] std::optional<generator_type> solve(unsigned threads = 0) const;
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an observation \a interval of the next output from the PRNG.
+   *
+   * Once enough observations have been fed, a reconstruction is attempted on the
+   * most recent window, and again after every further #window_stride observations
+   * if it fails.
+   *
+   * \note Each attempt reduces the lattice on the calling thread, which takes about
+   *       0.3 s for `random() >> 8`, 2.5 s for `>> 16`, 6 s for `>> 18` and up to
+   *       a minute for `>> 20`. Callers that cannot block for as long should feed
+   *       the observations from a separate thread.
+   *
+   * \return The reconstructed generator, or \c std::nullopt if more observations
+   *         are needed or the solver is #impractical.
+   */
+  [[nodiscard]] std::optional<generator_type> feed(output_interval interval);
+
+private:
+  static constexpr std::size_t window_stride = 31; ///< Steps between attempted windows.
+
+  std::vector<output_interval> observations;
+  std::uint64_t max_width = 1; ///< Width of the widest observed internal state.
+  
+  /**
+   * \brief Attempts to reconstruct the generator from the window starting at
+   *        observation \a first.
+   */
+  [[nodiscard]] std::optional<generator_type> solve_window(std::size_t first, std::stop_token stop) const;
+};
+
+inline std::optional<std::size_t> interval_solver::required_samples() const noexcept
+{
+  const auto lat = lattice();
+  if (!lat.practical())
+    return std::nullopt;
+
+  return lat.span();
+}
+
+inline auto interval_solver::feed(output_interval interval) -> std::optional<generator_type>
+{
+  assert(interval.lo <= interval.hi && interval.hi <= generator_type::max());
+
+  // width of the interval for the internal state, which also hides the parity
+  max_width = std::max(max_width, 2 * (std::uint64_t(interval.hi) - interval.lo + 1));
+  if (impractical()) {
+    observations = {};
+    return std::nullopt;
+  }
+
+  observations.push_back(interval);
+
+  const auto required = required_samples();
+  if (!required || size() < *required || (size() - *required) % window_stride != 0)
+    return std::nullopt;
+
+  return solve_window(size() - *required, {});
+}
+
+inline auto interval_solver::solve(unsigned threads) const -> std::optional<generator_type>
+{
+  const auto required = required_samples();
+  if (!required || size() < *required)
+    return std::nullopt;
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  const auto windows = std::min<std::size_t>(threads, (size() - *required) / window_stride + 1);
+  return first_success<generator_type>(windows, [&](std::size_t i, std::stop_token stop) {
+    return solve_window(size() - *required - i * window_stride, stop);
+  });
+}
+
+inline auto interval_solver::solve_window(std::size_t first, std::stop_token stop) const
+  -> std::optional<generator_type>
+{
+  const auto lat = lattice();
+  assert(first + lat.span() <= size());
+
+  const auto state_at = [&](std::size_t offset) {
+    const auto& interval = observations[first + offset];
+    return hidden_state{.base = 2 * interval.lo, .width = 2 * (std::uint64_t(interval.hi) - interval.lo + 1)};
+  };
+
+  for (const auto& table : lat.candidates(state_at, stop)) {
+    bool feasible = true;
+    generator_type gen{table};
+    for (auto it = observations.begin() + first + table.size(); it != observations.end(); ++it) {
+      if (!it->contains(gen())) {
+        feasible = false;
+        break;
+      }
+    }
+
+    if (feasible)
+      return gen;
+  }
+
+  return std::nullopt;
+}
+
+}
+
+#endif // PREDICTING_RANDOM_INTERVAL_SOLVER_HPP
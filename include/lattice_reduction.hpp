@@ -0,0 +1,134 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_LATTICE_REDUCTION_HPP
+#define PREDICTING_RANDOM_LATTICE_REDUCTION_HPP
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <stop_token>
+#include <utility>
+#include <vector>
+
+namespace predicting_random
+{
+
+/**
+ * \brief A basis of an integer lattice, stored as row vectors.
+ */
+using lattice_basis = std::vector<std::vector<std::int64_t>>;
+
+/**
+ * \brief Reduces \a basis in place using the Lenstra-Lenstra-Lovász algorithm.
+ *
+ * The Gram-Schmidt coefficients are kept in extended precision and row \c k is
+ * recomputed from exact dot products whenever the reduction visits it, which is
+ * slower than updating the coefficients in place on swaps but does not drift for
+ * the dimensions (~100) and entry sizes (~2^32) used in this project.
+ *
+ * \param [in,out] basis The basis to reduce. All rows must have the same length.
+ * \param [in]     stop  Requests that the reduction be abandoned.
+ * \param [in]     delta The Lovász constant, in `(0.25, 1)`.
+ *
+ * \return \c false if and only if the reduction was abandoned through \a stop, in
+ *         which case \a basis still generates the same lattice but is not reduced.
+ *
+ * \note Reducing first with a small \a delta (e.g. `0.75`) and then again with a
+ *       large one is typically several times faster than reducing with the large
+ *       \a delta directly.
+ */
+inline bool lll_reduce(lattice_basis& basis, std::stop_token stop = {}, long double delta = 0.99L)
+{
+  using real = long double;
+
+  const int rows = static_cast<int>(basis.size());
+  if (rows < 2)
+    return true;
+
+  const auto columns = basis[0].size();
+  std::vector<std::vector<real>> mu(rows, std::vector<real>(rows));
+  std::vector<real> norms(rows); // squared norms of the Gram-Schmidt vectors
+
+  const auto dot = [&](int i, int j) {
+    real result = 0;
+    for (std::size_t t = 0; t < columns; ++t)
+      result += static_cast<real>(basis[i][t]) * static_cast<real>(basis[j][t]);
+    return result;
+  };
+
+  const auto orthogonalize = [&](int k) {
+    for (int j = 0; j < k; ++j) {
+      real sum = dot(k, j);
+      for (int l = 0; l < j; ++l)
+        sum -= mu[j][l] * mu[k][l] * norms[l];
+      mu[k][j] = sum / norms[j];
+    }
+
+    real sum = dot(k, k);
+    for (int l = 0; l < k; ++l)
+      sum -= mu[k][l] * mu[k][l] * norms[l];
+    norms[k] = sum;
+  };
+
+  orthogonalize(0);
+  for (int k = 1; k < rows;) {
+    if (stop.stop_requested())
+      return false;
+
+    orthogonalize(k);
+
+    // size reduction; large quotients lose precision in mu, so recompute after them
+    // (a bounded number of times, as the recomputed mu may remain imprecise)
+    for (int pass = 0; pass < 8; ++pass) {
+      bool imprecise = false;
+      for (int l = k - 1; l >= 0; --l) {
+        const real q = std::round(mu[k][l]);
+        if (q == 0)
+          continue;
+
+        // the reduced row fits, so wrapping intermediate products are harmless
+        const auto qi = static_cast<std::uint64_t>(static_cast<std::int64_t>(q));
+        for (std::size_t t = 0; t < columns; ++t) {
+          const auto lhs = static_cast<std::uint64_t>(basis[k][t]);
+          const auto rhs = static_cast<std::uint64_t>(basis[l][t]);
+          basis[k][t] = static_cast<std::int64_t>(lhs - qi * rhs);
+        }
+
+        for (int i = 0; i < l; ++i)
+          mu[k][i] -= q * mu[l][i];
+        mu[k][l] -= q;
+        imprecise = imprecise || std::fabs(q) > real(1 << 20);
+      }
+
+      if (!imprecise)
+        break;
+      orthogonalize(k);
+    }
+
+    real sum = dot(k, k);
+    for (int l = 0; l < k; ++l)
+      sum -= mu[k][l] * mu[k][l] * norms[l];
+    norms[k] = sum;
+
+    if (norms[k] < (delta - mu[k][k - 1] * mu[k][k - 1]) * norms[k - 1]) {
+      std::swap(basis[k], basis[k - 1]);
+      k = std::max(1, k - 1);
+      if (k == 1)
+        orthogonalize(0);
+    } else {
+      ++k;
+    }
+  }
+
+  return true;
+}
+
+}
+
+#endif // PREDICTING_RANDOM_LATTICE_REDUCTION_HPP
@@ -0,0 +1,223 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_LOW_BIT_SOLVER_HPP
+#define PREDICTING_RANDOM_LOW_BIT_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// LOW BIT SOLVER EXPLANATION
+//
+// Applications frequently only expose the low K bits of output, through either
+// `random() % 2^K` or `random() & (2^K - 1)`. Following the notation in
+// solver.hpp, the observed value is
+//  o_{i} mod 2^K = (x_{i} mod 2^(K+1) - (x_{i} mod 2)) / 2.
+//
+// Since addition only carries towards the MSB, the low K+1 bits of the internal
+// state evolve independently of the rest:
+//  x_{i} = x_{i-3} + x_{i-31} (mod 2^(K+1)).
+// The relation used by the full solver therefore still holds, modulo 2^K:
+//  o_{i} = o_{i-3} + o_{i-31} + (x_{i-3} mod 2) * (x_{i-31} mod 2) (mod 2^K),
+// so carry events can be detected from the low bits alone, even for K = 1. These
+// events feed into the same parity system as the full solver.
+//
+// Once the parities are solved, the only unknown bit plane of the low K+1 bits is
+// known, and the low K+1 bits of the internal state can be reconstructed. Higher
+// bit planes are never observed, so the full internal state cannot be recovered,
+// but the low K bits of all future output are predicted by low_bit_generator.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstdint>
+
+#include <limits>
+#include <optional>
+
+#include "cyclic_fixed_queue.hpp"
+#include "prng.hpp"
+#include "solver.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief A generator which produces the low \a Bits bits of the output of the
+ *        generator implemented by #reference_generator.
+ *
+ * Only the low `Bits + 1` bits of the internal state are stored.
+ *
+ * This type satisfies the concept `std::uniform_random_bit_generator`.
+ */
+template<int Bits>
+  requires (1 <= Bits && Bits <= 31)
+class low_bit_generator
+{
+public:
+  using result_type = std::uint32_t;
+  using table_type  = cyclic_fixed_queue<result_type, 31>;
+
+  static constexpr int bits = Bits; ///< The number of low bits produced.
+
+  /**
+   * \brief The mask of the internal state bits tracked by this generator.
+   */
+  static constexpr result_type state_mask = std::numeric_limits<result_type>::max() >> (31 - Bits);
+
+  static constexpr result_type min() noexcept { return 0; }
+  static constexpr result_type max() noexcept { return state_mask >> 1; }
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Initializes the internal state directly from \a table.
+   *
+   * Bits of \a table outside of #state_mask are discarded.
+   */
+  explicit constexpr low_bit_generator(const table_type& table) noexcept : queue_(table)
+  {
+    for (auto& state : queue_)
+      state &= state_mask;
+  }
+
+  /**
+   * \brief Initializes the generator to produce the low bits of \a gen.
+   */
+  explicit constexpr low_bit_generator(const reference_generator& gen) noexcept
+    : low_bit_generator(gen.table()) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const low_bit_generator&, const low_bit_generator&) = default;
+
+  /**
+   * \brief Returns the low bits of the next internal state value.
+   */
+  [[nodiscard]] constexpr result_type peek_state() const noexcept { return (queue_(-3) + queue_(-31)) & state_mask; }
+
+  /**
+   * \brief Returns the next output value.
+   */
+  [[nodiscard]] constexpr result_type peek() const noexcept { return peek_state() >> 1; }
+
+  /**
+   * \brief Returns a reference to the internal state.
+   */
+  [[nodiscard]] constexpr const table_type& table() const noexcept { return queue_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Generates the low bits of a pseudo-random value, advancing the state by
+   *        one position.
+   */
+  constexpr result_type advance() noexcept { return queue_.pop_and_push(peek_state()) >> 1; }
+
+  /**
+   * \brief Generates the low bits of a pseudo-random value, advancing the state by
+   *        one position.
+   */
+  constexpr result_type operator()() noexcept { return advance(); }
+
+private:
+  table_type queue_;
+};
+
+/**
+ * \brief A solver for #reference_generator which only observes the low \a Bits
+ *        bits of each output.
+ */
+template<int Bits>
+  requires (1 <= Bits && Bits <= 31)
+class low_bit_solver
+{
+public:
+  using generator_type = low_bit_generator<Bits>; ///< The reconstructed generator type.
+  using value_type = typename generator_type::result_type;
+
+  /**
+   * \brief The mask of the output bits observed by this solver.
+   */
+  static constexpr value_type mask = generator_type::max();
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  constexpr low_bit_solver() noexcept = default;
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds the low bits of an output \a value from the PRNG.
+   *
+   * Bits of \a value outside of #mask are ignored, so `random()` may be passed
+   * directly.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept;
+
+private:
+  cyclic_fixed_queue<value_type, 31> history; ///< Keeps track of recent values.
+  parity_system parities;                     ///< Parities of recent states and
+                                              ///< the equations over them.
+
+  /**
+   * \brief Reconstructs the low bits of the target generator.
+   *
+   * The system must be solvable, i.e. `parities.solvable()`.
+   */
+  [[nodiscard]] constexpr generator_type solve() noexcept;
+};
+
+template<int Bits> requires (1 <= Bits && Bits <= 31)
+constexpr auto low_bit_solver<Bits>::feed(value_type value) noexcept
+  -> std::optional<generator_type>
+{
+  value &= mask;
+
+  if (history.ssize() < 31) {
+    history.push(value);
+    parities.advance();
+  } else {
+    const auto o31 = history(-31); // o_{i-31} mod 2^Bits
+    const auto o3  = history(-3);  // o_{i-3}  mod 2^Bits
+
+    history.pop_and_push(value);
+    const auto step = parities.advance();
+
+    const auto expected = (o31 + o3) & mask;
+    if (value != expected) {
+      assert(value == ((expected + 1u) & mask));
+
+      if (parities.push_carry(step))
+        return solve();
+    }
+  }
+
+  return std::nullopt;
+}
+
+template<int Bits> requires (1 <= Bits && Bits <= 31)
+constexpr auto low_bit_solver<Bits>::solve() noexcept -> generator_type
+{
+  assert(parities.solvable());
+
+  // parity_bits ordered from oldest (LSB) to most recent (MSB)
+  auto table = history;
+  for (auto parity_bits = parities.solve_parities(); auto& state : table) {
+    state = (state << 1) | (parity_bits & 1u);
+    parity_bits >>= 1;
+  }
+
+  return generator_type{table};
+}
+
+}
+
+#endif // PREDICTING_RANDOM_LOW_BIT_SOLVER_HPP
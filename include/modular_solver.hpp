@@ -0,0 +1,326 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_MODULAR_SOLVER_HPP
+#define PREDICTING_RANDOM_MODULAR_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// MODULAR SOLVER EXPLANATION
+//
+// Games and sampling code frequently expose `random() % N` for small N, such as
+// `% 6`, `% 52` or `% 100`. Following the notation in solver.hpp, the outputs obey
+//  o_{i} = o_{i-3} + o_{i-31} + c_{i} - 2^31 * w_{i},
+// over the integers, where c_{i} is the carry from the parities and w_{i} is set
+// when the sum wraps. Taken modulo N, the observations r_{i} = o_{i} mod N give
+//  r_{i} - r_{i-3} - r_{i-31} = c_{i} - 2^31 * w_{i} (mod N),
+// and the four possible steps (c_{i}, w_{i}) have distinct residues unless N
+// divides one of 2^31 or 2^31 +/- 1. Every carry and wrap is therefore recovered
+// from the observations, and any other residue proves that the output does not
+// come from the generator.
+//
+// With every step known, the relation between outputs holds over the integers. Any
+// later output is then a combination of the 31 outputs in a window,
+//  o_{n} = Sum[c_{n,j} * o_{j}, {j in [0 .. 30]}] + e_{n},
+// where the offset e_{n} accumulates the known steps, and this holds modulo 2^B for
+// any B. Writing o_{i} = r_{i} + N * k_{i}, where 0 <= k_{i} < ceil((2^31 - r_{i}) / N),
+// is the form solved by hidden_state_lattice, with a relation over B bits rather
+// than the 32 bits of the internal state. Each observation contributes about
+// B - 31 + log2(N / 2^v) bits, where 2^v is the power of two dividing N, so even
+// `% 6` is solved from a few thousand observations.
+//
+// The window determines every observed output, which are fed to solver to recover
+// the parities, giving the generator.
+//
+// IMPLEMENTATION NOTES
+//
+// B is limited by the precision of the lattice reduction, which keeps the basis in
+// 64-bit integers and the Gram-Schmidt coefficients in extended precision.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "hidden_state_lattice.hpp"
+#include "prng.hpp"
+#include "solver.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief The number of bits of the relation between outputs reduced by
+ *        #modular_solver.
+ */
+inline constexpr int modular_relation_bits = 48;
+
+/**
+ * \brief The lattice used by #modular_solver to reconstruct output observed modulo
+ *        \a N.
+ */
+template<std::uint32_t N>
+inline constexpr hidden_state_lattice modular_lattice{
+  ((std::uint64_t(1) << 31) + N - 1) / N, N, modular_relation_bits};
+
+/**
+ * \brief Indicates whether #modular_solver supports the modulus \a N: \a N is
+ *        below `2^31`, does not divide `2^31` or `2^31 +/- 1`, and
+ *        #modular_lattice is practical to reduce.
+ */
+template<std::uint32_t N>
+inline constexpr bool practical_modulus = [] {
+  constexpr std::uint64_t wrap = (std::uint64_t(1) << 31) % N;
+  return N > 1 && N < (std::uint32_t(1) << 31) && wrap != 0 && wrap != 1 && wrap != N - 1
+    && modular_lattice<N>.practical();
+}();
+
+/**
+ * \brief A solver for #reference_generator which only observes each output
+ *        modulo \a N.
+ */
+template<std::uint32_t N>
+  requires practical_modulus<N>
+class modular_solver
+{
+public:
+  using generator_type = reference_generator; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type;
+
+  static constexpr value_type modulus = N; ///< The modulus applied to each output.
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  modular_solver() = default;
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief The number of windows attempted by #feed before the solver fails.
+   */
+  static constexpr std::size_t max_attempts = 16;
+
+  /**
+   * \brief Returns the lattice used to reconstruct the generator.
+   */
+  [[nodiscard]] static constexpr hidden_state_lattice lattice() noexcept { return modular_lattice<N>; }
+
+  /**
+   * \brief Returns the number of observations needed before a reconstruction is
+   *        attempted.
+   */
+  [[nodiscard]] static constexpr std::size_t required_samples() noexcept { return lattice().span(); }
+
+  /**
+   * \brief Returns \c true if an observation could not have come from the target
+   *        generator, or #max_attempts windows failed to reconstruct a generator,
+   *        in which case further observations are ignored.
+   */
+  [[nodiscard]] bool failed() const noexcept { return attempts == max_attempts; }
+
+  /**
+   * \brief Returns the number of observations fed to the solver.
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return fed; }
+
+  /**
+   * \brief Attempts to reconstruct the target generator from the observations so
+   *        far.
+   *
+   * Up to \a threads windows of observations, starting from the most recent, are
+   * tried concurrently; the first consistent reconstruction is returned.
+   *
+   * \param [in] threads The maximum number of concurrent attempts, or `0` to use
+   *                     the number of hardware threads.
+   *
+   * \return A generator positioned after the last observation, or \c std::nullopt
+   *         if no window produced a generator consistent with the observations.
+   */
+  [[nodiscard]] std::optional<generator_type> solve(unsigned threads = 0) const;
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value from the PRNG, taken modulo #modulus.
+   *
+   * Once #required_samples observations have been fed, a reconstruction is
+   * attempted on the most recent window, and again after every further
+   * #window_stride observations if it fails, up to #max_attempts times.
+   *
+   * \return The reconstructed generator, or \c std::nullopt if more observations
+   *         are needed or the solver has #failed.
+   */
+  [[nodiscard]] std::optional<generator_type> feed(value_type value);
+
+private:
+  static constexpr std::size_t window_stride = 31; ///< Steps between attempted windows.
+
+  /**
+   * \brief The residue of a step which wraps, `-2^31`, modulo #modulus.
+   */
+  static constexpr value_type wrap_residue = N - static_cast<value_type>((std::uint64_t(1) << 31) % N);
+
+  static constexpr std::uint8_t carry = 1; ///< Step flag for `c_{i} = 1`.
+  static constexpr std::uint8_t wrap  = 2; ///< Step flag for `w_{i} = 1`.
+
+  std::size_t fed = 0;
+  std::size_t attempts = 0;         ///< The number of windows attempted by #feed.
+  std::vector<value_type> residues; ///< The observations, modulo #modulus.
+  std::vector<std::uint8_t> steps;  ///< The step flags leading to each observation.
+
+  /**
+   * \brief Attempts to reconstruct the generator from the window starting at
+   *        observation \a first.
+   */
+  [[nodiscard]] std::optional<generator_type> solve_window(std::size_t first, std::stop_token stop) const;
+
+  /**
+   * \brief Reconstructs the generator from the outputs \a window starting at
+   *        observation \a first, if it is consistent with every later observation.
+   */
+  [[nodiscard]] std::optional<generator_type> extend_window(std::size_t first, const reference_table& window) const;
+};
+
+template<std::uint32_t N> requires practical_modulus<N>
+auto modular_solver<N>::feed(value_type value) -> std::optional<generator_type>
+{
+  assert(value < modulus);
+  if (failed())
+    return std::nullopt;
+
+  ++fed;
+  std::uint8_t step = 0;
+  if (residues.size() >= 31) {
+    const auto lag3  = residues[residues.size() - 3];
+    const auto lag31 = residues[residues.size() - 31];
+    const auto delta = static_cast<value_type>(
+      (std::uint64_t(value) + 2 * std::uint64_t(N) - lag3 - lag31) % N);
+
+    if (delta == 0)
+      step = 0;
+    else if (delta == 1)
+      step = carry;
+    else if (delta == wrap_residue)
+      step = wrap;
+    else if (delta == (wrap_residue + 1) % N)
+      step = carry | wrap;
+    else {
+      // no step of the generator leads to this residue
+      attempts = max_attempts;
+      residues = {};
+      steps = {};
+      return std::nullopt;
+    }
+  }
+
+  residues.push_back(value);
+  steps.push_back(step);
+
+  constexpr auto span = required_samples();
+  if (residues.size() < span || (residues.size() - span) % window_stride != 0)
+    return std::nullopt;
+
+  auto result = solve_window(residues.size() - span, {});
+  if (!result && ++attempts == max_attempts) {
+    residues = {};
+    steps = {};
+  }
+  return result;
+}
+
+template<std::uint32_t N> requires practical_modulus<N>
+auto modular_solver<N>::solve(unsigned threads) const -> std::optional<generator_type>
+{
+  constexpr auto span = required_samples();
+  if (residues.size() < span)
+    return std::nullopt;
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  const auto windows = std::min<std::size_t>(threads, (residues.size() - span) / window_stride + 1);
+  return first_success<generator_type>(windows, [&](std::size_t i, std::stop_token stop) {
+    return solve_window(residues.size() - span - i * window_stride, stop);
+  });
+}
+
+template<std::uint32_t N> requires practical_modulus<N>
+auto modular_solver<N>::solve_window(std::size_t first, std::stop_token stop) const
+  -> std::optional<generator_type>
+{
+  constexpr auto lat = lattice();
+  constexpr auto span = required_samples();
+  assert(first + span <= residues.size());
+
+  // offsets e_{n} of later outputs from the combination of the window, modulo 2^64
+  std::vector<std::uint64_t> offsets(span);
+  for (std::size_t n = 31; n < span; ++n) {
+    const auto step = steps[first + n];
+    offsets[n] = offsets[n - 3] + offsets[n - 31] + (step & carry) - (step & wrap ? std::uint64_t(1) << 31 : 0);
+  }
+
+  const auto state_at = [&](std::size_t offset) {
+    const auto residue = residues[first + offset];
+    return hidden_state{
+      .base = residue - offsets[offset],
+      .width = ((std::uint64_t(1) << 31) - residue + N - 1) / N};
+  };
+
+  for (const auto& window : lat.candidates(state_at, stop)) {
+    if (auto gen = extend_window(first, window))
+      return gen;
+  }
+
+  return std::nullopt;
+}
+
+template<std::uint32_t N> requires practical_modulus<N>
+auto modular_solver<N>::extend_window(std::size_t first, const reference_table& window) const
+  -> std::optional<generator_type>
+{
+  constexpr std::int64_t period = std::int64_t(1) << 31;
+
+  // the outputs follow from the window and the steps; the first full generator is
+  // recovered by solver once it has seen enough carries
+  std::vector<std::int64_t> outputs(window.begin(), window.end());
+  outputs.reserve(residues.size() - first);
+
+  solver parity_solver;
+  std::optional<generator_type> gen;
+  for (std::size_t n = 0; first + n < residues.size(); ++n) {
+    if (n >= 31) {
+      const auto step = steps[first + n];
+      const auto output = outputs[n - 3] + outputs[n - 31] + (step & carry) - (step & wrap ? period : 0);
+      if (output < 0 || output >= period || static_cast<value_type>(output) % N != residues[first + n])
+        return std::nullopt;
+      outputs.push_back(output);
+    }
+
+    const auto output = static_cast<value_type>(outputs[n]);
+    if (gen) {
+      if (gen->advance() != output)
+        return std::nullopt;
+    } else {
+      gen = parity_solver.feed(output);
+    }
+  }
+
+  return gen;
+}
+
+}
+
+#endif // PREDICTING_RANDOM_MODULAR_SOLVER_HPP
@@ -0,0 +1,286 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_MT19937_SOLVER_HPP
+#define PREDICTING_RANDOM_MT19937_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// MT19937 SOLVER EXPLANATION
+//
+// std::mt19937 keeps 624 words x_{i} and emits temper(x_{i}), where temper is an
+// invertible linear map over GF(2). The words follow
+//  x_{i} := x_{i-227} ^ twist((x_{i-624} & 0x80000000) | (x_{i-623} & 0x7FFFFFFF)),
+// so any 624 consecutive words determine all later ones, wherever they fall
+// relative to the blocks in which the generator regenerates its state. Untempering
+// 624 consecutive outputs therefore recovers the state exactly.
+//
+// IMPLEMENTATION NOTES
+// untemper() is a fixed sequence of shifts, masks and XORs without branches, so the
+// batched overload of feed() untempers contiguous output in a loop that gcc and
+// clang vectorize at -O2 and above. As with libstdc++, mt19937_generator
+// regenerates all 624 words at once rather than one word per output.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <span>
+
+#include "cyclic_fixed_queue.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief A generator which produces output equivalent to `std::mt19937`.
+ *
+ * This type satisfies the concept `std::uniform_random_bit_generator`.
+ */
+class mt19937_generator
+{
+public:
+  using result_type = std::uint32_t;
+  using state_type  = std::array<result_type, 624>;
+
+  static constexpr std::size_t state_size = 624;
+  static constexpr std::size_t shift_size = 397;
+
+  static constexpr result_type default_seed = 5489u;
+
+  static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+  static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Initializes the generator using \a seed, as by the constructor of
+   *        `std::mt19937`.
+   */
+  explicit constexpr mt19937_generator(result_type seed = default_seed) noexcept
+    : words{}, index(state_size)
+  {
+    words[0] = seed;
+    for (std::size_t i = 1; i < state_size; ++i)
+      words[i] = 1812433253u * (words[i - 1] ^ (words[i - 1] >> 30)) + static_cast<result_type>(i);
+  }
+
+  /**
+   * \brief Initializes the generator from the last 624 words it produced, ordered
+   *        from oldest to most recent, so that it continues after them.
+   */
+  explicit constexpr mt19937_generator(const state_type& state) noexcept
+    : words(state), index(state_size) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const mt19937_generator& lhs, const mt19937_generator& rhs) noexcept
+  {
+    return lhs.state() == rhs.state();
+  }
+
+  /**
+   * \brief Returns the last 624 words produced, ordered from oldest to most
+   *        recent, as taken by the constructor.
+   */
+  [[nodiscard]] constexpr state_type state() const noexcept
+  {
+    if (index >= state_size)
+      return words;
+
+    const auto previous = previous_words();
+    state_type result;
+    const auto rest = std::copy(previous.begin() + index, previous.end(), result.begin());
+    std::copy_n(words.begin(), index, rest);
+    return result;
+  }
+
+  /**
+   * \brief Returns the output corresponding to the word \a value.
+   */
+  [[nodiscard]] static constexpr result_type temper(result_type value) noexcept
+  {
+    value ^= value >> 11;
+    value ^= (value << 7) & 0x9D2C'5680u;
+    value ^= (value << 15) & 0xEFC6'0000u;
+    value ^= value >> 18;
+    return value;
+  }
+
+  /**
+   * \brief Returns the word corresponding to the output \a value.
+   */
+  [[nodiscard]] static constexpr result_type untemper(result_type value) noexcept
+  {
+    value ^= value >> 18;
+    value ^= (value << 15) & 0xEFC6'0000u;
+
+    result_type x = value;
+    for (int i = 0; i < 4; ++i) // each pass fixes 7 more bits
+      x = value ^ ((x << 7) & 0x9D2C'5680u);
+
+    return x ^ (x >> 11) ^ (x >> 22);
+  }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type advance() noexcept
+  {
+    if (index >= state_size)
+      regenerate();
+    return temper(words[index++]);
+  }
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type operator()() noexcept { return advance(); }
+
+private:
+  state_type  words;
+  std::size_t index; ///< The position of the next word in #words.
+
+  /**
+   * \brief Replaces all words with the next 624 words.
+   */
+  constexpr void regenerate() noexcept;
+
+  /**
+   * \brief Returns the words replaced by the last call to #regenerate, of which
+   *        only those from #index onwards are recovered.
+   */
+  [[nodiscard]] constexpr state_type previous_words() const noexcept;
+};
+
+constexpr void mt19937_generator::regenerate() noexcept
+{
+  constexpr auto n = state_size;
+  constexpr auto m = shift_size;
+  constexpr auto next = [](result_type x, result_type y, result_type z) {
+    const result_type mixed = (x & 0x8000'0000u) | (y & 0x7FFF'FFFFu);
+    return z ^ (mixed >> 1) ^ ((mixed & 1u) * 0x9908'B0DFu);
+  };
+
+  // split so that no index wraps, as by libstdc++
+  std::size_t k = 0;
+  for (; k < n - m; ++k)
+    words[k] = next(words[k], words[k + 1], words[k + m]);
+  for (; k < n - 1; ++k)
+    words[k] = next(words[k], words[k + 1], words[k + m - n]);
+  words[n - 1] = next(words[n - 1], words[0], words[m - 1]);
+
+  index = 0;
+}
+
+constexpr auto mt19937_generator::previous_words() const noexcept -> state_type
+{
+  constexpr auto n = state_size;
+  constexpr auto m = shift_size;
+  assert(index > 0);
+
+  // word k of the block was produced from the upper bit of previous word k and the
+  // lower bits of previous word k + 1, which are recovered by inverting the twist;
+  // the word 227 places back lies later in the previous block for k < n - m, and
+  // is recovered first by going backwards
+  state_type previous{};
+  const auto mixed = [&](std::size_t k) {
+    const result_type z = k < n - m ? previous[k + m] : words[k + m - n];
+    const result_type twisted = words[k] ^ z;
+    const result_type odd = twisted >> 31;
+    return ((twisted ^ (odd * 0x9908'B0DFu)) << 1) | odd;
+  };
+
+  for (std::size_t k = n - 1; k >= index; --k)
+    previous[k] = (mixed(k) & 0x8000'0000u) | (mixed(k - 1) & 0x7FFF'FFFFu);
+
+  return previous;
+}
+
+/**
+ * \brief A solver for #mt19937_generator.
+ */
+class mt19937_solver
+{
+public:
+  using generator_type = mt19937_generator; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  constexpr mt19937_solver() noexcept = default;
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value from the PRNG.
+   *
+   * \return A generator positioned after \a value, once 624 outputs have been fed.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept
+  {
+    const auto word = generator_type::untemper(value);
+    if (history.ssize() < 624)
+      history.push(word);
+    else
+      history.pop_and_push(word);
+
+    if (history.ssize() < 624)
+      return std::nullopt;
+
+    typename generator_type::state_type state;
+    const auto [first, second] = history.segments();
+    std::copy(second.begin(), second.end(), std::copy(first.begin(), first.end(), state.begin()));
+    return generator_type{state};
+  }
+
+  /**
+   * \brief Feeds consecutive output \a values from the PRNG.
+   *
+   * \return A generator positioned after the last value, once 624 outputs have
+   *         been fed.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(std::span<const value_type> values) noexcept
+  {
+    constexpr std::size_t n = generator_type::state_size;
+    if (values.size() < n) {
+      std::optional<generator_type> result;
+      for (const auto value : values)
+        result = feed(value);
+      return result;
+    }
+
+    // only the last 624 values contribute to the state
+    typename generator_type::state_type state;
+    const value_type* last = values.data() + (values.size() - n);
+    for (std::size_t i = 0; i < n; ++i)
+      state[i] = generator_type::untemper(last[i]);
+
+    history.pop_n(history.size());
+    history.push_range(state);
+    return generator_type{state};
+  }
+
+private:
+  cyclic_fixed_queue<value_type, 624> history; ///< Keeps track of recent words.
+};
+
+}
+
+#endif // PREDICTING_RANDOM_MT19937_SOLVER_HPP
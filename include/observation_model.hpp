@@ -0,0 +1,352 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_OBSERVATION_MODEL_HPP
+#define PREDICTING_RANDOM_OBSERVATION_MODEL_HPP
+
+// ---------------------------------------------------------------------------------
+// OBSERVATION MODEL EXPLANATION
+//
+// Each solver in this project targets one way of exposing the output of random().
+// An observation model describes such an exposure as a type, so that
+//  model_solver<observation::shift<16>>
+// selects the matching solver at compile time and converts each observation into
+// what that solver consumes, without any dispatch per value.
+//
+// Monotone stages (exact, shift, scale) compose, where the second argument is
+// applied to the result of the first; for example
+//  observation::shift<8, observation::scale<1000000>>
+// observes `(random() >> 8) * 1000000 / 2^23`. Any composition of monotone stages
+// bounds the output to an interval, which is solved by interval_solver, provided
+// the widest interval is narrow enough for the reconstruction to be practical (see
+// practical_interval). Wider compositions, such as shift<8, scale<100>>, are
+// rejected at compile time.
+//
+// The other models (mask, mod, combine) apply directly to the output of random()
+// and do not compose, since their results no longer constrain the output in a
+// form supported by a solver. Such compositions are rejected at compile time. For
+// example, `(random() >> 16) % 100`, or shift<16, mod<100>>, hides the carries
+// into bit 16, so the steps that modular_solver recovers from the residues are
+// never known; each value also leaves two unknowns per output (the quotient by 100
+// and the 16 shifted bits) rather than the single bounded unknown
+// hidden_state_lattice solves for. Composition is therefore limited to chains of
+// shift and scale. Likewise, mod<N> only accepts the moduli accepted by
+// modular_solver (see practical_modulus), so that a model which cannot be solved
+// does not compile.
+//
+// Decimated output, where only every k-th output is observed, is not modeled either.
+// Every solver relates each observation to the observations 3 and 31 steps before
+// it, through o_{i} = o_{i-3} + o_{i-31} + c. Across a gap of k steps this becomes a
+// sum over the whole previous window with carries that are never observed.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstdint>
+
+#include <bit>
+#include <concepts>
+#include <optional>
+
+#include "combined_solver.hpp"
+#include "interval_solver.hpp"
+#include "low_bit_solver.hpp"
+#include "modular_solver.hpp"
+#include "prng.hpp"
+#include "solver.hpp"
+
+namespace predicting_random
+{
+
+namespace observation
+{
+
+/**
+ * \brief Specifies a monotone stage of an observation, which maps values in
+ *        `[0, input_range)` to values in `[0, range(input_range))`.
+ *
+ * The values mapping to the same result form an interval, given by `preimage`,
+ * of at most `max_width` values.
+ */
+template<typename Stage>
+concept monotone_stage = requires (std::uint32_t value, std::uint64_t input_range)
+{
+  { Stage::range(input_range) } -> std::same_as<std::uint64_t>;
+  { Stage::apply(value, input_range) } -> std::same_as<std::uint32_t>;
+  { Stage::preimage(value, input_range) } -> std::same_as<output_interval>;
+  { Stage::max_width(input_range) } -> std::same_as<std::uint64_t>;
+};
+
+/**
+ * \brief The number of distinct outputs of #reference_generator.
+ */
+inline constexpr std::uint64_t output_range = std::uint64_t(reference_generator::max()) + 1;
+
+/**
+ * \brief Indicates whether #interval_solver can practically reconstruct the
+ *        generator from observations through the monotone stage \a Stage, given
+ *        the widest interval of outputs it leaves.
+ */
+template<monotone_stage Stage>
+inline constexpr bool practical_interval = hidden_state_lattice{2 * Stage::max_width(output_range)}.practical();
+
+/**
+ * \brief Provides the model interface for a composition of monotone stages,
+ *        solved by #interval_solver.
+ *
+ * Compositions which are not #practical_interval provide no solver, so that they
+ * do not satisfy #observation_model.
+ */
+template<typename Derived>
+struct monotone_model
+{
+  using value_type  = std::uint32_t;
+  using solver_type = interval_solver;
+
+  [[nodiscard]] static solver_type make_solver() requires practical_interval<Derived> { return {}; }
+
+  [[nodiscard]] static constexpr value_type observe(reference_generator& gen) noexcept
+  {
+    return Derived::apply(gen(), output_range);
+  }
+
+  [[nodiscard]] static constexpr output_interval constrain(value_type value) noexcept
+  {
+    return Derived::preimage(value, output_range);
+  }
+};
+
+/**
+ * \brief Observes the output of random() unchanged, or ends a composition.
+ */
+struct exact
+{
+  using value_type  = std::uint32_t;
+  using solver_type = solver;
+
+  [[nodiscard]] static constexpr solver_type make_solver() noexcept { return {}; }
+  [[nodiscard]] static constexpr value_type observe(reference_generator& gen) noexcept { return gen(); }
+  [[nodiscard]] static constexpr value_type constrain(value_type value) noexcept { return value; }
+
+  [[nodiscard]] static constexpr std::uint64_t range(std::uint64_t input_range) noexcept { return input_range; }
+
+  [[nodiscard]] static constexpr std::uint32_t apply(std::uint32_t value, std::uint64_t) noexcept
+  {
+    return value;
+  }
+
+  [[nodiscard]] static constexpr output_interval preimage(std::uint32_t value, std::uint64_t) noexcept
+  {
+    return {.lo = value, .hi = value};
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t max_width(std::uint64_t) noexcept { return 1; }
+};
+
+/**
+ * \brief Observes `value >> Bits`, followed by \a Then.
+ */
+template<int Bits, monotone_stage Then = exact>
+  requires (0 <= Bits && Bits < 31)
+struct shift : monotone_model<shift<Bits, Then>>
+{
+  [[nodiscard]] static constexpr std::uint64_t range(std::uint64_t input_range) noexcept
+  {
+    return Then::range(input_range >> Bits);
+  }
+
+  [[nodiscard]] static constexpr std::uint32_t apply(std::uint32_t value, std::uint64_t input_range) noexcept
+  {
+    return Then::apply(value >> Bits, input_range >> Bits);
+  }
+
+  [[nodiscard]] static constexpr output_interval preimage(std::uint32_t value, std::uint64_t input_range) noexcept
+  {
+    const auto inner = Then::preimage(value, input_range >> Bits);
+    return {.lo = inner.lo << Bits, .hi = ((inner.hi + 1u) << Bits) - 1u};
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t max_width(std::uint64_t input_range) noexcept
+  {
+    return Then::max_width(input_range >> Bits) << Bits;
+  }
+};
+
+/**
+ * \brief Observes `value * Range / input_range`, rounded down, followed by \a Then.
+ *
+ * Applied to the output, this is the idiom `random() / (RAND_MAX + 1.0) * Range`;
+ * see scaled_output.
+ */
+template<std::uint32_t Range, monotone_stage Then = exact>
+  requires (Range > 0)
+struct scale : monotone_model<scale<Range, Then>>
+{
+  [[nodiscard]] static constexpr std::uint64_t range(std::uint64_t) noexcept
+  {
+    return Then::range(Range);
+  }
+
+  [[nodiscard]] static constexpr std::uint32_t apply(std::uint32_t value, std::uint64_t input_range) noexcept
+  {
+    return Then::apply(static_cast<std::uint32_t>(value * std::uint64_t(Range) / input_range), Range);
+  }
+
+  [[nodiscard]] static constexpr output_interval preimage(std::uint32_t value, std::uint64_t input_range) noexcept
+  {
+    assert(Range <= input_range);
+    const auto ceil_div = [](std::uint64_t n, std::uint64_t d) { return (n + d - 1) / d; };
+    const auto inner = Then::preimage(value, Range);
+    return {
+      .lo = static_cast<std::uint32_t>(ceil_div(inner.lo * input_range, Range)),
+      .hi = static_cast<std::uint32_t>(ceil_div((inner.hi + std::uint64_t(1)) * input_range, Range) - 1)};
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t max_width(std::uint64_t input_range) noexcept
+  {
+    // w consecutive values of the inner range span at most ceil(w * input_range / Range)
+    return (Then::max_width(Range) * input_range + Range - 1) / Range;
+  }
+};
+
+/**
+ * \brief Observes the low \a Bits bits of the output, as by `random() % 2^Bits`.
+ *
+ * Only the low bits of further output can be predicted, see low_bit_solver.
+ */
+template<int Bits>
+  requires (1 <= Bits && Bits <= 31)
+struct mask
+{
+  using value_type  = std::uint32_t;
+  using solver_type = low_bit_solver<Bits>;
+
+  [[nodiscard]] static constexpr solver_type make_solver() noexcept { return {}; }
+
+  [[nodiscard]] static constexpr value_type observe(reference_generator& gen) noexcept
+  {
+    return gen() & solver_type::mask;
+  }
+
+  [[nodiscard]] static constexpr value_type constrain(value_type value) noexcept { return value; }
+};
+
+/**
+ * \brief Observes the output modulo \a N, as by `random() % N`.
+ *
+ * Only the moduli accepted by #modular_solver are accepted; see
+ * #practical_modulus.
+ */
+template<std::uint32_t N>
+  requires practical_modulus<N>
+struct mod
+{
+  using value_type  = std::uint32_t;
+  using solver_type = modular_solver<N>;
+
+  [[nodiscard]] static solver_type make_solver() { return {}; }
+  [[nodiscard]] static constexpr value_type observe(reference_generator& gen) noexcept { return gen() % N; }
+  [[nodiscard]] static constexpr value_type constrain(value_type value) noexcept { return value; }
+};
+
+/**
+ * \brief Selects the solver for values combined from two outputs with a shift of
+ *        \a Shift.
+ */
+template<int Shift>
+struct combined_solver_for { using type = xor_shifted_solver<Shift>; };
+
+template<int Shift>
+  requires (Shift >= 31)
+struct combined_solver_for<Shift> { using type = concatenated_solver<Shift>; };
+
+/**
+ * \brief Observes values combined from two outputs, as by `lo ^ (hi << Shift)`
+ *        (or `|` when \a Shift is at least 31), where the calls are made in the
+ *        given \a Order.
+ */
+template<int Shift, call_order Order = call_order::high_first>
+  requires (2 <= Shift && Shift <= 33)
+struct combine
+{
+  using value_type  = std::uint64_t;
+  using solver_type = typename combined_solver_for<Shift>::type;
+
+  [[nodiscard]] static constexpr solver_type make_solver() noexcept { return solver_type{Order}; }
+
+  [[nodiscard]] static constexpr value_type observe(reference_generator& gen) noexcept
+  {
+    const std::uint64_t first  = gen();
+    const std::uint64_t second = gen();
+    return Order == call_order::low_first ? first ^ (second << Shift) : second ^ (first << Shift);
+  }
+
+  [[nodiscard]] static constexpr value_type constrain(value_type value) noexcept { return value; }
+};
+
+}
+
+/**
+ * \brief Specifies an observation model, which describes how the output of
+ *        #reference_generator is exposed and which solver reconstructs it.
+ */
+template<typename Model>
+concept observation_model = requires (reference_generator& gen, typename Model::value_type value)
+{
+  typename Model::solver_type;
+  { Model::make_solver() } -> std::same_as<typename Model::solver_type>;
+  { Model::observe(gen) } -> std::same_as<typename Model::value_type>;
+  Model::constrain(value);
+};
+
+/**
+ * \brief A solver for #reference_generator which observes output through
+ *        \a Model.
+ *
+ * Each observation is converted according to \a Model and fed to the solver it
+ * selects; the conversion is resolved at compile time.
+ */
+template<observation_model Model>
+class model_solver
+{
+public:
+  using model_type     = Model;
+  using solver_type    = typename Model::solver_type;
+  using generator_type = typename solver_type::generator_type; ///< The reconstructed generator type.
+  using value_type     = typename Model::value_type;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed observations.
+   */
+  model_solver() : inner(Model::make_solver()) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the underlying solver.
+   */
+  [[nodiscard]] const solver_type& backend() const noexcept { return inner; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an \a observation of the PRNG, as produced by `Model::observe`.
+   */
+  [[nodiscard]] std::optional<generator_type> feed(value_type observation)
+  {
+    return inner.feed(Model::constrain(observation));
+  }
+
+private:
+  solver_type inner;
+};
+
+}
+
+#endif // PREDICTING_RANDOM_OBSERVATION_MODEL_HPP
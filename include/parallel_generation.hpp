@@ -0,0 +1,162 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_PARALLEL_GENERATION_HPP
+#define PREDICTING_RANDOM_PARALLEL_GENERATION_HPP
+
+// ---------------------------------------------------------------------------------
+// PARALLEL GENERATION EXPLANATION
+//
+// Once a generator is solved, its future output may be wanted in bulk, far beyond
+// what a single core steps through in reasonable time. Since the states of
+// basic_reference_generator follow a linear recurrence, discard() places a copy of
+// the generator at any distance ahead in time logarithmic in the distance (see
+// prng.hpp). The output is therefore split into chunks, each generated by its own
+// copy of the generator placed at the start of the chunk, and the chunks are
+// handed out to as many threads as there are cores.
+//
+// generate_to_file maps the output file into memory and generates into the mapping
+// directly, so no copy is made between generation and the page cache. The blocks of
+// the file are allocated before it is mapped, since a write to a page of a sparse
+// file that the file system cannot back raises SIGBUS rather than reporting an
+// error.
+//
+// IMPLEMENTATION NOTES
+// Chunks are much smaller than the output divided among the threads, so that
+// threads which stall on page faults do not hold up the rest. Each chunk is
+// generated with sliding_window_backend, whose per-output cost is a load, and the
+// cost of placing the generator is negligible against the length of a chunk.
+// ---------------------------------------------------------------------------------
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define PREDICTING_RANDOM_HAS_MMAP 1
+#endif
+
+#include "prng.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief The number of outputs generated by a thread at a time in
+ *        #generate_parallel.
+ */
+inline constexpr std::size_t generation_chunk_size = std::size_t(1) << 22;
+
+/**
+ * \brief Writes the outputs following the current state of \a gen to \a output,
+ *        generating chunks of it concurrently.
+ *
+ * \param [in]  gen     The generator, which is not advanced.
+ * \param [out] output  The destination of the next `output.size()` outputs.
+ * \param [in]  threads The number of threads, or `0` to use the number of hardware
+ *                      threads.
+ */
+template<typename Backend>
+void generate_parallel(
+  const basic_reference_generator<Backend>& gen,
+  std::span<std::uint32_t>                  output,
+  unsigned                                  threads = 0)
+{
+  using chunk_generator = basic_reference_generator<sliding_window_backend<>>;
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  const std::size_t chunks = (output.size() + generation_chunk_size - 1) / generation_chunk_size;
+  threads = static_cast<unsigned>(std::min<std::size_t>(threads, chunks));
+
+  const chunk_generator origin{gen};
+  std::atomic<std::size_t> next_chunk{0};
+  const auto work = [&] {
+    for (std::size_t i; (i = next_chunk.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+      const std::size_t first = i * generation_chunk_size;
+      const auto chunk = output.subspan(first, std::min(generation_chunk_size, output.size() - first));
+
+      chunk_generator chunk_gen = origin;
+      chunk_gen.discard(first);
+      for (auto& value : chunk)
+        value = chunk_gen();
+    }
+  };
+
+  std::vector<std::jthread> workers;
+  for (unsigned t = 1; t < threads; ++t)
+    workers.emplace_back(work);
+  work();
+}
+
+#ifdef PREDICTING_RANDOM_HAS_MMAP
+
+/**
+ * \brief Writes the \a count outputs following the current state of \a gen to the
+ *        file at \a path, generating chunks of it concurrently.
+ *
+ * The file is created or truncated, and holds the outputs as consecutive
+ * `std::uint32_t` in native byte order. The file is allocated in full and mapped
+ * into memory, so that the outputs are generated into the page cache directly,
+ * and is written back before this function returns.
+ *
+ * \param [in] threads The number of threads, or `0` to use the number of hardware
+ *                     threads.
+ *
+ * \return The error which prevented the file from being written, if any.
+ */
+template<typename Backend>
+std::error_code generate_to_file(
+  const basic_reference_generator<Backend>& gen,
+  std::uint64_t                             count,
+  const char*                               path,
+  unsigned                                  threads = 0)
+{
+  const auto last_error = [] { return std::error_code(errno, std::system_category()); };
+
+  const int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return last_error();
+
+  const std::uint64_t bytes = count * sizeof(std::uint32_t);
+  std::error_code result;
+  if (bytes == 0) {
+    // nothing to map
+  } else if (const int error = ::posix_fallocate(fd, 0, static_cast<off_t>(bytes)); error != 0) {
+    // reports the error directly rather than through errno, and may leave part of
+    // the file allocated
+    result = std::error_code(error, std::system_category());
+    (void)::ftruncate(fd, 0);
+  } else if (void* data = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+             data == MAP_FAILED) {
+    result = last_error();
+  } else {
+    generate_parallel(gen, std::span(static_cast<std::uint32_t*>(data), count), threads);
+    if (::msync(data, bytes, MS_SYNC) != 0)
+      result = last_error();
+    ::munmap(data, bytes);
+  }
+
+  if (::close(fd) != 0 && !result)
+    result = last_error();
+  return result;
+}
+
+#endif
+
+}
+
+#endif // PREDICTING_RANDOM_PARALLEL_GENERATION_HPP
@@ -0,0 +1,186 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_PREDICTED_VIEW_HPP
+#define PREDICTING_RANDOM_PREDICTED_VIEW_HPP
+
+// ---------------------------------------------------------------------------------
+// PREDICTED VIEW EXPLANATION
+//
+// basic_predicted_view presents the outputs following the state of a solved
+// generator as an unbounded input range, so that they can be consumed with the
+// range adaptors of the standard library, for example
+//  predicted_view(gen) | std::views::transform(f) | std::views::take(n)
+// instead of calling the generator from within a loop.
+//
+// As with std::ranges::istream_view, the view holds the state and its iterator
+// refers back to the view, so each output is read once, and iteration resumes from
+// where it left off when begin() is called again. Like the generator, a copy of the
+// view continues independently. Adaptors applied to an lvalue view copy it, so wrap
+// the view in std::ranges::ref_view for separate pipelines to continue from one
+// another.
+//
+// IMPLEMENTATION NOTES
+// The view keeps its states as sliding_window_backend does (see prng.hpp), and
+// computes a block of them at a time with compute_states. The iterator keeps its
+// own pointer into the block, so dereferencing it is a load and a shift.
+// Incrementing it compares the pointer against the end of the block and stores the
+// index back to the view, which the loop never reads back. Computing a block is
+// kept out of the increment, so that the increment is inlined into the adaptors'
+// loop.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <ranges>
+#include <span>
+
+#include "prng.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief An unbounded input range over the outputs of a #basic_reference_generator,
+ *        computed \a Block outputs at a time.
+ */
+template<std::size_t Block = 256>
+  requires (Block > 0)
+class basic_predicted_view : public std::ranges::view_interface<basic_predicted_view<Block>>
+{
+public:
+  using value_type = std::uint32_t;
+
+  class iterator;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a view of the outputs following the current state of
+   *        \a gen.
+   */
+  template<typename Backend>
+  explicit constexpr basic_predicted_view(const basic_reference_generator<Backend>& gen) noexcept
+    : states{}, index(states.size())
+  {
+    const reference_table table = gen.table();
+    assert(table.size() == 31);
+
+    const auto [first, second] = table.segments();
+    std::copy(second.begin(), second.end(), std::copy(first.begin(), first.end(), states.end() - 31));
+  }
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns an iterator to the next output not yet read through the view.
+   */
+  [[nodiscard]] constexpr iterator begin() noexcept
+  {
+    if (index == states.size())
+      compute_block();
+    return iterator(*this);
+  }
+
+  /**
+   * \brief Returns the sentinel of the view, which is never reached.
+   */
+  [[nodiscard]] constexpr std::unreachable_sentinel_t end() const noexcept { return {}; }
+
+  /**
+   * \brief Returns a generator positioned at the next output not yet read through
+   *        the view.
+   */
+  [[nodiscard]] constexpr reference_generator generator() const noexcept
+  {
+    reference_table table;
+    table.push_range(std::span<const value_type>(states.data() + index - 31, 31));
+    return reference_generator(table);
+  }
+
+private:
+  std::array<value_type, 31 + Block> states;
+  std::size_t index; ///< The index of the state of the next output in #states.
+
+  /**
+   * \brief Moves the last 31 states to the front and computes the next block.
+   */
+  [[gnu::noinline]] constexpr void compute_block() noexcept
+  {
+    std::copy(states.end() - 31, states.end(), states.begin());
+    compute_states(states);
+    index = 31;
+  }
+};
+
+/**
+ * \brief An iterator over a #basic_predicted_view, which reads outputs from it.
+ */
+template<std::size_t Block>
+  requires (Block > 0)
+class basic_predicted_view<Block>::iterator
+{
+public:
+  using iterator_concept = std::input_iterator_tag;
+  using value_type       = typename basic_predicted_view::value_type;
+  using difference_type  = std::ptrdiff_t;
+
+  iterator(iterator&&) = default;
+  iterator& operator=(iterator&&) = default;
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the current output.
+   */
+  [[nodiscard]] constexpr value_type operator*() const noexcept { return *current >> 1; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Moves to the next output.
+   */
+  constexpr iterator& operator++() noexcept
+  {
+    if (++current == view->states.data() + view->states.size()) [[unlikely]] {
+      view->compute_block();
+      current = view->states.data() + 31;
+    }
+    view->index = static_cast<std::size_t>(current - view->states.data());
+    return *this;
+  }
+
+  /**
+   * \brief Moves to the next output.
+   */
+  constexpr void operator++(int) noexcept { ++*this; }
+
+private:
+  friend class basic_predicted_view;
+
+  basic_predicted_view* view;
+  const value_type* current; ///< The state of the current output, at the view's `index`.
+
+  explicit constexpr iterator(basic_predicted_view& view) noexcept
+    : view(&view), current(view.states.data() + view.index) {}
+};
+
+/**
+ * \brief An unbounded input range over the outputs of a #basic_reference_generator.
+ */
+using predicted_view = basic_predicted_view<>;
+
+}
+
+#endif // PREDICTING_RANDOM_PREDICTED_VIEW_HPP
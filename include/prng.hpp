@@ -6,26 +6,216 @@
 #ifndef PREDICTING_RANDOM_PRNG_HPP
 #define PREDICTING_RANDOM_PRNG_HPP
 
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
 #include <limits>
+#include <span>
 
 #include "cyclic_fixed_queue.hpp"
 
 namespace predicting_random
 {
 
+/**
+ * \brief The table of the last 31 states of #basic_reference_generator, ordered from
+ *        oldest to most recent.
+ */
+using reference_table = cyclic_fixed_queue<std::uint32_t, 31, queue_cursor::back>;
+
+/**
+ * \brief Requires that \a Backend can keep the state of #basic_reference_generator.
+ */
+template<typename Backend>
+concept reference_generator_backend = std::equality_comparable<Backend>
+  && std::constructible_from<Backend, const reference_table&>
+  && requires (Backend& backend, const Backend& const_backend)
+{
+  { const_backend.peek_state() } -> std::same_as<std::uint32_t>;
+  { const_backend.table() } -> std::convertible_to<reference_table>;
+  { backend.advance_state() } -> std::same_as<std::uint32_t>;
+};
+
+/**
+ * \brief Keeps the state of #basic_reference_generator in a cyclic queue of 31
+ *        states, computing each state as it is requested.
+ */
+class ring_backend
+{
+public:
+  using result_type = std::uint32_t;
+  
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+  
+  /**
+   * \brief Initializes the state directly from \a table.
+   */
+  explicit constexpr ring_backend(const reference_table& table) noexcept : queue_(table) {}
+  
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+  
+  friend constexpr bool operator==(const ring_backend&, const ring_backend&) = default;
+  
+  /**
+   * \brief Returns the next state.
+   */
+  [[nodiscard]] constexpr result_type peek_state() const noexcept { return queue_.at<-3>() + queue_.at<-31>(); }
+  
+  /**
+   * \brief Returns a reference to the last 31 states.
+   */
+  [[nodiscard]] constexpr const reference_table& table() const noexcept { return queue_; }
+  
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+  
+  /**
+   * \brief Advances by one state, returning it.
+   */
+  constexpr result_type advance_state() noexcept { return queue_.pop_and_push(peek_state()); }
+  
+private:
+  reference_table queue_;
+};
+
+/**
+ * \brief Computes the states of #basic_reference_generator that follow the first 31
+ *        elements of \a states into the remaining elements.
+ */
+constexpr void compute_states(std::span<std::uint32_t> states) noexcept
+{
+  assert(states.size() >= 31);
+  
+  // x[i - 3] is carried in registers, leaving only the load of x[i - 31], which
+  // was stored long before; vectorizing across the lag of 3 would instead load
+  // values straddling the stores that immediately precede them
+  std::uint32_t* x = states.data();
+  std::uint32_t a = x[28], b = x[29], c = x[30];
+  std::size_t i = 31;
+  for (; i + 3 <= states.size(); i += 3) {
+    x[i]     = a += x[i - 31];
+    x[i + 1] = b += x[i - 30];
+    x[i + 2] = c += x[i - 29];
+  }
+  for (; i < states.size(); ++i)
+    x[i] = x[i - 3] + x[i - 31];
+}
+
+/**
+ * \brief Keeps the state of #basic_reference_generator in a linear buffer of
+ *        `31 + Block` states, computing \a Block states at a time.
+ *
+ * Each block is computed by a plain loop over the buffer, without wrapping indices,
+ * after which the last 31 states are moved to the front of the buffer. Handing out
+ * a computed state then takes a single load.
+ */
+template<std::size_t Block = 256>
+  requires (Block > 0)
+class sliding_window_backend
+{
+public:
+  using result_type = std::uint32_t;
+  
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+  
+  /**
+   * \brief Initializes the state directly from \a table, which must be full.
+   */
+  explicit constexpr sliding_window_backend(const reference_table& table) noexcept
+    : words{}, position(words.size())
+  {
+    assert(table.size() == 31);
+    
+    // place the table where the next block expects the last 31 states
+    const auto [first, second] = table.segments();
+    std::copy(second.begin(), second.end(), std::copy(first.begin(), first.end(), words.end() - 31));
+  }
+  
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+  
+  friend constexpr bool operator==(const sliding_window_backend& lhs, const sliding_window_backend& rhs) noexcept
+  {
+    return std::equal(lhs.window(), lhs.window() + 31, rhs.window());
+  }
+  
+  /**
+   * \brief Returns the next state.
+   */
+  [[nodiscard]] constexpr result_type peek_state() const noexcept
+  {
+    if (position < words.size())
+      return words[position];
+    return words[position - 3] + words[position - 31];
+  }
+  
+  /**
+   * \brief Returns the last 31 states.
+   */
+  [[nodiscard]] constexpr reference_table table() const noexcept
+  {
+    reference_table result;
+    result.push_range(std::span<const result_type>(window(), 31));
+    return result;
+  }
+  
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+  
+  /**
+   * \brief Advances by one state, returning it.
+   */
+  constexpr result_type advance_state() noexcept
+  {
+    if (position == words.size())
+      compute_block();
+    return words[position++];
+  }
+  
+private:
+  std::array<result_type, 31 + Block> words;
+  std::size_t position; ///< The index of the next state in #words.
+  
+  /**
+   * \brief Returns a pointer to the last 31 states.
+   */
+  [[nodiscard]] constexpr const result_type* window() const noexcept { return words.data() + position - 31; }
+  
+  /**
+   * \brief Moves the last 31 states to the front and computes the next block.
+   */
+  constexpr void compute_block() noexcept
+  {
+    std::copy(words.end() - 31, words.end(), words.begin());
+    compute_states(words);
+    position = 31;
+  }
+};
+
 /**
  * \brief An implementation of a PRNG used in glibc as described here:
  *        https://www.mathstat.dal.ca/~selinger/random/
  *
+ * The states are kept by \a Backend. All backends produce identical output, and
+ * generators with different backends convert into each other through #table.
+ *
  * This type satisfies the concept `std::uniform_random_bit_generator`.
  */
-class reference_generator
+template<reference_generator_backend Backend = ring_backend>
+class basic_reference_generator
 {
 public:
-  using result_type = std::uint32_t;
-  using table_type  = cyclic_fixed_queue<result_type, 31>;
+  using result_type  = std::uint32_t;
+  using table_type   = reference_table;
+  using backend_type = Backend;
   
   static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
   static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max() >> 1; }
@@ -36,28 +226,46 @@ public:
   /**
    * \brief Initializes the PRNG using \a seed.
    */
-  constexpr reference_generator(result_type seed) noexcept : queue_(table_from_seed(seed))
+  constexpr basic_reference_generator(result_type seed) noexcept : backend_(table_from_seed(seed))
   {
-    // queue_ contains initial state at this point
+    // backend_ contains initial state at this point
     // advance the PRNG to make the output less predictable
     for (int i = 34; i < 344; ++i)
       advance();
   }
   
+  /**
+   * \brief Initializes the PRNG using \a seed and advances it by \a offset outputs,
+   *        jumping over the outputs discarded by seeding and the \a offset outputs
+   *        at once.
+   */
+  constexpr basic_reference_generator(result_type seed, unsigned long long offset) noexcept
+    : backend_(table_from_seed(seed))
+  {
+    discard(344 - 34 + offset);
+  }
+
   /**
    * \brief Initializes the internal state directly from \a table.
    */
-  constexpr reference_generator(const table_type& table) noexcept : queue_(table) {}
+  constexpr basic_reference_generator(const table_type& table) noexcept : backend_(table) {}
+  
+  /**
+   * \brief Initializes the internal state to that of \a other.
+   */
+  template<typename OtherBackend>
+  explicit constexpr basic_reference_generator(const basic_reference_generator<OtherBackend>& other) noexcept
+    : backend_(other.table()) {}
   
   // -------------------------------------------------------------------------------
   // OBSERVERS
   
-  friend constexpr bool operator==(const reference_generator&, const reference_generator&) = default;
+  friend constexpr bool operator==(const basic_reference_generator&, const basic_reference_generator&) = default;
   
   /**
    * \brief Returns the next internal state value.
    */
-  [[nodiscard]] constexpr result_type peek_state() const noexcept { return queue_(-3) + queue_(-31); }
+  [[nodiscard]] constexpr result_type peek_state() const noexcept { return backend_.peek_state(); }
   
   /**
    * \brief Returns the next output value.
@@ -65,9 +273,10 @@ public:
   [[nodiscard]] constexpr result_type peek() const noexcept { return peek_state() >> 1; }
   
   /**
-   * \brief Returns a reference to the internal state.
+   * \brief Returns the internal state, or a reference to it if \a Backend keeps it
+   *        as a table.
    */
-  [[nodiscard]] constexpr const table_type& table() const noexcept { return queue_; }
+  [[nodiscard]] constexpr decltype(auto) table() const noexcept { return backend_.table(); }
   
   // -------------------------------------------------------------------------------
   // MODIFIERS
@@ -75,23 +284,110 @@ public:
   /**
    * \brief Generates a pseudo-random value, advancing the state by one position.
    */
-  constexpr result_type advance() noexcept { return queue_.pop_and_push(peek_state()) >> 1; }
+  constexpr result_type advance() noexcept { return backend_.advance_state() >> 1; }
   
   /**
    * \brief Generates a pseudo-random value, advancing the state by one position.
    */
   constexpr result_type operator()() noexcept { return advance(); }
+  
+  /**
+   * \brief Advances the state by \a count positions, as if by as many calls to
+   *        #advance, in time logarithmic in \a count.
+   */
+  constexpr void discard(unsigned long long count) noexcept;
 
 private:
-  table_type queue_;
+  using polynomial = std::array<result_type, 31>; ///< Coefficients of `1, X, ..., X^30`.
+  
+  Backend backend_;
   
   /**
    * \brief Returns internal state for a generator using \a seed.
    */
   [[nodiscard]] static constexpr table_type table_from_seed(result_type seed) noexcept;
+  
+  /**
+   * \brief Returns `X^count` modulo the characteristic polynomial
+   *        `X^31 - X^28 - 1`.
+   */
+  [[nodiscard]] static constexpr polynomial power_of_x(unsigned long long count) noexcept;
 };
 
-constexpr auto reference_generator::table_from_seed(result_type seed) noexcept
+/**
+ * \brief The glibc TYPE_3 generator, with states kept in a cyclic queue.
+ */
+using reference_generator = basic_reference_generator<>;
+
+template<reference_generator_backend Backend>
+constexpr void basic_reference_generator<Backend>::discard(unsigned long long count) noexcept
+{
+  // stepping is cheaper than the polynomial arithmetic for short distances; the
+  // two break even between about 6000 and 10000 outputs, at -O3 and -O2
+  if (count < 8192) {
+    for (; count > 0; --count)
+      backend_.advance_state();
+    return;
+  }
+  
+  // The states s_{i} satisfy s_{i} = s_{i-3} + s_{i-31}, so if
+  //  X^k = c_{0} + c_{1} X + ... + c_{30} X^30 (mod X^31 - X^28 - 1),
+  // then s_{k} = c_{0} s_{0} + c_{1} s_{1} + ... + c_{30} s_{30}, where s_{0} is the
+  // oldest state in the table. Multiplying by X moves to the following state.
+  polynomial c = power_of_x(count);
+  
+  polynomial window;
+  std::ranges::copy(table(), window.begin());
+  
+  table_type result;
+  for (int j = 0; j < 31; ++j) {
+    result_type state = 0;
+    for (int i = 0; i < 31; ++i)
+      state += c[i] * window[i];
+    result.push(state);
+    
+    // multiply by X: X^31 = X^28 + 1
+    const result_type top = c[30];
+    std::shift_right(c.begin(), c.end(), 1);
+    c[0] = top;
+    c[28] += top;
+  }
+  
+  backend_ = Backend(result);
+}
+
+template<reference_generator_backend Backend>
+constexpr auto basic_reference_generator<Backend>::power_of_x(unsigned long long count) noexcept
+  -> polynomial
+{
+  polynomial result{};
+  result[0] = 1;
+  for (int bit = std::bit_width(count) - 1; bit >= 0; --bit) {
+    // square, then reduce from the top using X^k = X^{k-3} + X^{k-31}
+    std::array<result_type, 61> product{};
+    for (int i = 0; i < 31; ++i) {
+      for (int j = 0; j < 31; ++j)
+        product[i + j] += result[i] * result[j];
+    }
+    for (int k = 60; k >= 31; --k) {
+      product[k - 3]  += product[k];
+      product[k - 31] += product[k];
+    }
+    std::copy_n(product.begin(), 31, result.begin());
+    
+    if ((count >> bit) & 1u) {
+      const result_type top = result[30];
+      std::shift_right(result.begin(), result.end(), 1);
+      result[0] = top;
+      result[28] += top;
+    }
+  }
+  
+  return result;
+}
+
+template<reference_generator_backend Backend>
+constexpr auto basic_reference_generator<Backend>::table_from_seed(result_type seed) noexcept
   -> table_type
 {
   table_type result;
@@ -0,0 +1,246 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_RAND_R_SOLVER_HPP
+#define PREDICTING_RANDOM_RAND_R_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// RAND_R SOLVER EXPLANATION
+//
+// glibc rand_r() advances a 32-bit LCG state three times per call,
+//  s_{i+1} := 1103515245 * s_{i} + 12345 (mod 2^32),
+// and concatenates bits [16, 27) of the first state with bits [16, 26) of the
+// second and third states into a 31-bit output.
+//
+// Since multiplication and addition only carry towards the MSB, bits [0, k) of a
+// state only depend on bits [0, k) of the previous state. No output depends on
+// bits [27, 32) of any state, so only the state modulo 2^27 can (and need) be
+// recovered; rand_r_generator reproduces the output from it exactly.
+//
+// Write the first state of a call as s = H * 2^16 + L, where H is observed. Then
+// bits [16, 26) of the second state are
+//  floor((1103515245 * L + 12345) / 2^16) + 1103515245 * H (mod 2^10),
+// so L must lie in the bucket of a precomputed index, keyed on the first term,
+// which holds 64 of the 2^16 values of L. Each is checked against the third state,
+// which almost always leaves a single candidate; any others are filtered by
+// further output.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace predicting_random
+{
+
+/**
+ * \brief A generator which produces output equivalent to glibc `rand_r()`.
+ *
+ * This type satisfies the concept `std::uniform_random_bit_generator`.
+ */
+class rand_r_generator
+{
+public:
+  using result_type = std::uint32_t;
+
+  static constexpr result_type multiplier = 1103515245u;
+  static constexpr result_type increment  = 12345u;
+
+  static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+  static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max() >> 1; }
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Initializes the generator to the state `*seed` passed to `rand_r()`.
+   */
+  explicit constexpr rand_r_generator(result_type seed) noexcept : state_(seed) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const rand_r_generator&, const rand_r_generator&) = default;
+
+  /**
+   * \brief Returns the current state, as would be stored to `*seed` by `rand_r()`.
+   */
+  [[nodiscard]] constexpr result_type state() const noexcept { return state_; }
+
+  /**
+   * \brief Returns the next output value.
+   */
+  [[nodiscard]] constexpr result_type peek() const noexcept { return rand_r_generator(*this).advance(); }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one call.
+   */
+  constexpr result_type advance() noexcept
+  {
+    result_type result = step() >> 16 & 0x7FFu;
+    result = (result << 10) ^ (step() >> 16 & 0x3FFu);
+    result = (result << 10) ^ (step() >> 16 & 0x3FFu);
+    return result;
+  }
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one call.
+   */
+  constexpr result_type operator()() noexcept { return advance(); }
+
+private:
+  result_type state_;
+
+  constexpr result_type step() noexcept { return state_ = multiplier * state_ + increment; }
+};
+
+/**
+ * \brief A solver for #rand_r_generator.
+ *
+ * The reconstructed generator agrees with the target on all output, but only the
+ * low 27 bits of its state are recovered.
+ */
+class rand_r_solver
+{
+public:
+  using generator_type = rand_r_generator; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type;
+
+  /**
+   * \brief The bits of the state that determine the output.
+   */
+  static constexpr value_type state_mask = (value_type(1) << 27) - 1u;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  rand_r_solver() = default;
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the states, after the last call, consistent with the output fed
+   *        so far.
+   */
+  [[nodiscard]] const std::vector<value_type>& candidates() const noexcept { return states; }
+
+  /**
+   * \brief Returns the states, after the call, for which `rand_r()` would return
+   *        \a value, masked by #state_mask.
+   */
+  [[nodiscard]] static std::vector<value_type> candidates_for(value_type value);
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value from the PRNG.
+   *
+   * \return A generator positioned after the call, once a single candidate state
+   *         remains.
+   */
+  [[nodiscard]] std::optional<generator_type> feed(value_type value);
+
+private:
+  bool started = false;
+  std::vector<value_type> states; ///< Candidate states after the last call.
+
+  /**
+   * \brief Index over the low 16 bits `L` of a state, bucketed by bits [16, 26) of
+   *        `multiplier * L + increment`.
+   */
+  struct low_bit_index
+  {
+    std::array<std::uint32_t, 1025> offsets; ///< Bounds of each bucket in #values.
+    std::array<std::uint16_t, 65536> values;
+  };
+
+  [[nodiscard]] static const low_bit_index& index();
+};
+
+inline auto rand_r_solver::index() -> const low_bit_index&
+{
+  static const low_bit_index result = [] {
+    constexpr auto bucket = [](std::uint32_t low) {
+      return (generator_type::multiplier * low + generator_type::increment) >> 16 & 0x3FFu;
+    };
+
+    low_bit_index index{};
+    for (std::uint32_t low = 0; low < 65536; ++low)
+      ++index.offsets[bucket(low) + 1];
+    for (std::size_t i = 1; i < index.offsets.size(); ++i)
+      index.offsets[i] += index.offsets[i - 1];
+
+    auto next = index.offsets;
+    for (std::uint32_t low = 0; low < 65536; ++low)
+      index.values[next[bucket(low)]++] = static_cast<std::uint16_t>(low);
+
+    return index;
+  }();
+
+  return result;
+}
+
+inline auto rand_r_solver::candidates_for(value_type value) -> std::vector<value_type>
+{
+  assert(value <= generator_type::max());
+  constexpr auto a = generator_type::multiplier;
+  constexpr auto c = generator_type::increment;
+
+  const value_type high   = value >> 20;          // bits [16, 27) of the first state
+  const value_type second = value >> 10 & 0x3FFu; // bits [16, 26) of the second state
+  const value_type third  = value & 0x3FFu;       // bits [16, 26) of the third state
+
+  const auto& lookup = index();
+  const auto bucket = (second - a * high) & 0x3FFu;
+
+  std::vector<value_type> result;
+  for (auto i = lookup.offsets[bucket]; i < lookup.offsets[bucket + 1]; ++i) {
+    const value_type s1 = high << 16 | lookup.values[i];
+    const value_type s2 = a * s1 + c;
+    const value_type s3 = a * s2 + c;
+    if ((s3 >> 16 & 0x3FFu) == third)
+      result.push_back(s3 & state_mask);
+  }
+
+  return result;
+}
+
+inline auto rand_r_solver::feed(value_type value) -> std::optional<generator_type>
+{
+  if (!started) {
+    started = true;
+    states = candidates_for(value);
+  } else {
+    std::erase_if(states, [value](value_type state) { return generator_type{state}() != value; });
+    for (auto& state : states) {
+      generator_type gen{state};
+      (void)gen();
+      state = gen.state() & state_mask;
+    }
+  }
+
+  assert(!states.empty());
+  if (states.size() != 1)
+    return std::nullopt;
+
+  return generator_type{states.front()};
+}
+
+}
+
+#endif // PREDICTING_RANDOM_RAND_R_SOLVER_HPP
@@ -0,0 +1,225 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_RANLUX_SOLVER_HPP
+#define PREDICTING_RANDOM_RANLUX_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// RANLUX SOLVER EXPLANATION
+//
+// std::ranlux24_base and std::ranlux48_base are subtract-with-carry generators,
+//  x_{i} := x_{i-S} - x_{i-R} - c_{i-1} (mod 2^W),
+//  c_{i} := 1 if x_{i-S} < x_{i-R} + c_{i-1}, and 0 otherwise,
+// with (W, S, R) being (24, 10, 24) and (48, 5, 12) respectively. Unlike TYPE_3 (see
+// solver.hpp), each output is an entire word of the state. As with the carry of
+// TYPE_3, the borrow is the only hidden quantity and it is exposed by
+//  c_{i-1} = x_{i-S} - x_{i-R} - x_{i} (mod 2^W),
+// so R + 1 consecutive outputs determine the state, including the carry.
+//
+// The seeding of subtract_with_carry_generator follows libstdc++, which agrees with
+// the standard: each word is drawn from std::linear_congruential_engine<UInt,
+// 40014, 0, 2147483563>, and the carry is set if and only if the last word is 0.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <concepts>
+#include <limits>
+#include <optional>
+
+#include "cyclic_fixed_queue.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief A generator which produces output equivalent to
+ *        `std::subtract_with_carry_engine<UInt, W, S, R>` as implemented by
+ *        libstdc++.
+ *
+ * This type satisfies the concept `std::uniform_random_bit_generator`.
+ */
+template<std::unsigned_integral UInt, std::size_t W, std::size_t S, std::size_t R>
+  requires (0 < S && S < R && 0 < W && W <= std::numeric_limits<UInt>::digits)
+class subtract_with_carry_generator
+{
+public:
+  using result_type = UInt;
+  using table_type  = cyclic_fixed_queue<result_type, R>;
+
+  static constexpr std::size_t word_size = W;
+  static constexpr std::size_t short_lag = S;
+  static constexpr std::size_t long_lag  = R;
+
+  static constexpr result_type default_seed = 19780503u;
+
+  static constexpr result_type min() noexcept { return 0; }
+  static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max() >> (std::numeric_limits<result_type>::digits - W); }
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Initializes the generator using \a seed, as by the constructor of the
+   *        corresponding standard engine.
+   */
+  explicit constexpr subtract_with_carry_generator(result_type seed = default_seed) noexcept
+    : queue_(table_from_seed(seed)), carry_(queue_.back() == 0) {}
+
+  /**
+   * \brief Initializes the internal state directly from \a table, ordered from
+   *        oldest to most recent word, and \a carry.
+   */
+  constexpr subtract_with_carry_generator(const table_type& table, bool carry) noexcept
+    : queue_(table), carry_(carry) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const subtract_with_carry_generator&, const subtract_with_carry_generator&) = default;
+
+  /**
+   * \brief Returns a reference to the words of the internal state.
+   */
+  [[nodiscard]] constexpr const table_type& table() const noexcept { return queue_; }
+
+  /**
+   * \brief Returns the current carry.
+   */
+  [[nodiscard]] constexpr bool carry() const noexcept { return carry_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type advance() noexcept
+  {
+    const result_type xs = queue_(-static_cast<std::ptrdiff_t>(S));
+    const result_type xr = queue_(-static_cast<std::ptrdiff_t>(R));
+    const result_type borrow = carry_;
+
+    carry_ = xs < xr + borrow;
+    return queue_.pop_and_push((xs - xr - borrow) & max());
+  }
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type operator()() noexcept { return advance(); }
+
+private:
+  table_type queue_;
+  bool carry_;
+
+  /**
+   * \brief Returns the words for a generator using \a seed.
+   */
+  [[nodiscard]] static constexpr table_type table_from_seed(result_type seed) noexcept;
+};
+
+template<std::unsigned_integral UInt, std::size_t W, std::size_t S, std::size_t R>
+  requires (0 < S && S < R && 0 < W && W <= std::numeric_limits<UInt>::digits)
+constexpr auto subtract_with_carry_generator<UInt, W, S, R>::table_from_seed(result_type seed) noexcept
+  -> table_type
+{
+  // std::linear_congruential_engine<result_type, 40014u, 0u, 2147483563u>
+  std::uint64_t lcg = (seed == 0 ? default_seed : seed) % 2147483563u;
+  if (lcg == 0)
+    lcg = 1;
+
+  constexpr std::size_t words_per_value = (W + 31) / 32;
+
+  table_type result;
+  for (std::size_t i = 0; i < R; ++i) {
+    result_type sum = 0;
+    for (std::size_t j = 0; j < words_per_value; ++j) {
+      lcg = lcg * 40014u % 2147483563u;
+      sum += static_cast<result_type>(lcg) << (32 * j);
+    }
+    result.push(sum & max());
+  }
+
+  return result;
+}
+
+/**
+ * \brief A solver for #subtract_with_carry_generator.
+ */
+template<std::unsigned_integral UInt, std::size_t W, std::size_t S, std::size_t R>
+  requires (0 < S && S < R && 0 < W && W <= std::numeric_limits<UInt>::digits)
+class subtract_with_carry_solver
+{
+public:
+  using generator_type = subtract_with_carry_generator<UInt, W, S, R>; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  constexpr subtract_with_carry_solver() noexcept = default;
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value from the PRNG.
+   *
+   * \return A generator positioned after \a value, once `R + 1` outputs have been
+   *         fed.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept;
+
+private:
+  typename generator_type::table_type history; ///< Keeps track of recent values.
+};
+
+template<std::unsigned_integral UInt, std::size_t W, std::size_t S, std::size_t R>
+  requires (0 < S && S < R && 0 < W && W <= std::numeric_limits<UInt>::digits)
+constexpr auto subtract_with_carry_solver<UInt, W, S, R>::feed(value_type value) noexcept
+  -> std::optional<generator_type>
+{
+  assert(value <= generator_type::max());
+
+  if (history.size() < R) {
+    history.push(value);
+    return std::nullopt;
+  }
+
+  const value_type xs = history(-static_cast<std::ptrdiff_t>(S)); // x_{i-S}
+  const value_type xr = history(-static_cast<std::ptrdiff_t>(R)); // x_{i-R}
+  history.pop_and_push(value);
+
+  const value_type borrow = (xs - xr - value) & generator_type::max(); // c_{i-1}
+  assert(borrow <= 1);
+
+  return generator_type{history, xs < xr + borrow};
+}
+
+/**
+ * \brief A generator equivalent to `std::ranlux24_base`.
+ *
+ * The word type is `std::uint_fast32_t`, as for `std::ranlux24_base`, so that seeds
+ * beyond 32 bits are reduced as by libstdc++ rather than truncated.
+ */
+using ranlux24_base_generator = subtract_with_carry_generator<std::uint_fast32_t, 24, 10, 24>;
+
+/**
+ * \brief A generator equivalent to `std::ranlux48_base`.
+ */
+using ranlux48_base_generator = subtract_with_carry_generator<std::uint64_t, 48, 5, 12>;
+
+using ranlux24_base_solver = subtract_with_carry_solver<std::uint_fast32_t, 24, 10, 24>;
+using ranlux48_base_solver = subtract_with_carry_solver<std::uint64_t, 48, 5, 12>;
+
+}
+
+#endif // PREDICTING_RANDOM_RANLUX_SOLVER_HPP
@@ -0,0 +1,203 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_SHARED_STREAM_HPP
+#define PREDICTING_RANDOM_SHARED_STREAM_HPP
+
+// ---------------------------------------------------------------------------------
+// SHARED STREAM EXPLANATION
+//
+// Threads that draw from a single generator under a lock serialize on it, and the
+// order in which they receive values depends on scheduling. shared_stream instead
+// numbers the outputs of a generator from its state at construction, and hands out
+// ranges of these numbers, or tickets, with a single atomic addition. Each thread
+// then produces the outputs of its range by itself: it places a generator at the
+// start of the range through discard() (see prng.hpp) and generates the range in
+// bulk. Every output therefore goes to exactly one thread, and is the same value a
+// single-threaded run would produce at the same position.
+//
+// IMPLEMENTATION NOTES
+// Each thread draws through its own shared_stream::reader, which keeps its
+// generator between ranges, so only the distance to the next range is jumped. The
+// origin is never modified after construction, and the ticket counter sits on its
+// own cache line, so the only contended write is the addition.
+//
+// A reader which claimed only what each draw asks for would, with small draws,
+// jump over the short ranges of the other readers on every draw, paying for a jump
+// (or stepping through the gap) per handful of outputs, and contend on the counter
+// just as often. Readers therefore claim blocks of at least block_size() outputs
+// and serve draws from their block in order; the outputs at the end of a block
+// which are too few for a draw are skipped, and go to no thread.
+// ---------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <span>
+
+#include "prng.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief A stream of the outputs of a #basic_reference_generator shared among
+ *        threads, which claim ranges of it without locking.
+ */
+template<reference_generator_backend Backend = sliding_window_backend<>>
+class shared_stream
+{
+public:
+  using generator_type = basic_reference_generator<Backend>;
+  using value_type = typename generator_type::result_type;
+
+  class reader;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief The default number of outputs claimed at a time by a #reader.
+   *
+   * Generating a block takes several times longer than jumping over the blocks of
+   * other readers to reach it.
+   */
+  static constexpr std::size_t default_block_size = std::size_t(1) << 16;
+
+  /**
+   * \brief Constructs to a stream of the outputs following the current state of
+   *        \a origin, from which readers claim at least \a block_size outputs at a
+   *        time.
+   */
+  template<typename OriginBackend>
+  explicit shared_stream(
+    const basic_reference_generator<OriginBackend>& origin,
+    std::size_t                                     block_size = default_block_size)
+    : origin_(origin), block_size_(std::max<std::size_t>(block_size, 1)) {}
+
+  shared_stream(const shared_stream&) = delete;
+  shared_stream& operator=(const shared_stream&) = delete;
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the generator positioned at the start of the stream.
+   */
+  [[nodiscard]] const generator_type& origin() const noexcept { return origin_; }
+
+  /**
+   * \brief Returns the minimum number of outputs claimed at a time by a #reader.
+   */
+  [[nodiscard]] std::size_t block_size() const noexcept { return block_size_; }
+
+  /**
+   * \brief Returns the number of outputs claimed so far.
+   */
+  [[nodiscard]] std::uint64_t claimed() const noexcept { return next.load(std::memory_order_relaxed); }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Returns a reader which draws from this stream, for use by one thread.
+   */
+  [[nodiscard]] reader make_reader() noexcept { return reader(*this); }
+
+  /**
+   * \brief Claims the next \a count outputs of the stream.
+   *
+   * \return The index of the first output claimed.
+   */
+  std::uint64_t claim(std::size_t count) noexcept
+  {
+    return next.fetch_add(count, std::memory_order_relaxed);
+  }
+
+private:
+  const generator_type origin_;
+  const std::size_t block_size_;
+  alignas(64) std::atomic<std::uint64_t> next{0}; ///< The index of the next output
+                                                  ///< to claim.
+};
+
+/**
+ * \brief Draws ranges of a #shared_stream on behalf of a single thread.
+ */
+template<reference_generator_backend Backend>
+class shared_stream<Backend>::reader
+{
+public:
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the index of the output the reader's generator is positioned at.
+   */
+  [[nodiscard]] std::uint64_t position() const noexcept { return position_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Writes the next `output.size()` outputs of the reader's block to
+   *        \a output, first claiming a new block of at least #block_size outputs
+   *        if too few remain.
+   *
+   * \return The index of the first output written.
+   */
+  std::uint64_t draw(std::span<value_type> output) noexcept
+  {
+    if (output.size() > block_end - block_next) {
+      const std::size_t count = std::max(output.size(), stream->block_size());
+      block_next = stream->claim(count);
+      block_end = block_next + count;
+    }
+
+    const std::uint64_t first = block_next;
+    block_next += output.size();
+    generate(first, output);
+    return first;
+  }
+
+  /**
+   * \brief Writes the outputs of the stream at indices starting from \a first to
+   *        \a output, whether or not they were claimed.
+   *
+   * Reaching \a first takes a jump unless it is #position or shortly after it,
+   * so callers claiming ranges directly should claim ranges of at least
+   * #block_size outputs.
+   */
+  void generate(std::uint64_t first, std::span<value_type> output) noexcept
+  {
+    if (first < position_) {
+      gen = stream->origin_;
+      position_ = 0;
+    }
+
+    gen.discard(first - position_);
+    for (auto& value : output)
+      value = gen();
+    position_ = first + output.size();
+  }
+
+private:
+  friend class shared_stream;
+
+  shared_stream* stream;
+  generator_type gen;            ///< The generator positioned at #position_.
+  std::uint64_t position_;       ///< The index of the next output of #gen.
+  std::uint64_t block_next = 0;  ///< The index of the next output of the block.
+  std::uint64_t block_end = 0;   ///< The index past the end of the block.
+
+  explicit reader(shared_stream& stream) noexcept
+    : stream(&stream), gen(stream.origin_), position_(0) {}
+};
+
+}
+
+#endif // PREDICTING_RANDOM_SHARED_STREAM_HPP
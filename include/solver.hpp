@@ -69,6 +69,9 @@
 #include <cassert>
 #include <cstdint>
 
+#include <array>
+#include <bit>
+#include <concepts>
 #include <optional>
 #include <limits>
 
@@ -79,8 +82,9 @@ namespace predicting_random
 {
 
 /**
- * \brief A specialized type representing 32x32 matrices over GF(2) which maintains
- *        the matrix in row semi-canonical form.
+ * \brief A specialized type representing square matrices over GF(2), with one
+ *        \a Row per row and column, which maintains the matrix in row 
+ *        semi-canonical form.
  *
  * A matrix is in semi-canonical form if its pivots are always along the diagonal, 
  * with zero rows occupying the space between pivot rows. The matrix can be 
@@ -91,21 +95,22 @@ namespace predicting_random
  * result of maintaining the semi-canonical form, Gaussian elimination takes place 
  * in incremental steps.
  */
-class semicanonical_b32x32
+template<std::unsigned_integral Row>
+class semicanonical_matrix
 {
 public:
-  using row_type = std::uint32_t;
+  using row_type = Row;
   static constexpr int size = std::numeric_limits<row_type>::digits;
   
   /**
    * \brief Constructs to the zero matrix (all elements `0`).
    */
-  constexpr semicanonical_b32x32() noexcept : rows_{/*ZERO*/} {}
+  constexpr semicanonical_matrix() noexcept : rows_{/*ZERO*/} {}
   
   /**
    * \brief Returns the column-wise sum of rows selected by \a select, modulo 2.
    */
-  constexpr row_type row_sum(std::uint32_t select) const noexcept;
+  constexpr row_type row_sum(row_type select) const noexcept;
   
   /**
    * \brief Returns the row at \a index.
@@ -126,36 +131,108 @@ private:
   alignas(64 * sizeof(row_type)) std::array<row_type, size> rows_;
 };
 
-class solver
+using semicanonical_b32x32 = semicanonical_matrix<std::uint32_t>; ///< 32x32 over GF(2).
+using semicanonical_b64x64 = semicanonical_matrix<std::uint64_t>; ///< 64x64 over GF(2).
+
+/**
+ * \brief Tracks the internal state parities of the target generator in terms of
+ *        the initial system parities and collects equations over them.
+ *
+ * Each call to #advance corresponds to the target generator emitting one output.
+ * When a carry event is observed for that output, the step is passed back to
+ * #push_carry, which records the parities of the two contributing states as `1`.
+ */
+class parity_system
 {
 public:
-  using generator_type = reference_generator; ///< The targeted generator type.
-  using value_type = typename generator_type::result_type; 
+  /**
+   * \brief The parities contributing to a single step, in terms of the initial
+   *        system parities.
+   */
+  struct step_type
+  {
+    std::uint32_t lag31; ///< The parity of `x_{i-31}`.
+    std::uint32_t lag3;  ///< The parity of `x_{i-3}`.
+  };
   
   // -------------------------------------------------------------------------------
   // CONSTRUCTORS
   
-  /** 
-   * \brief Constructs to a solver that is ready to be fed output.
+  /**
+   * \brief Constructs to a system positioned at the first output of the generator,
+   *        with no equations.
    */
-  constexpr solver() noexcept;
+  constexpr parity_system() noexcept;
   
   // -------------------------------------------------------------------------------
   // OBSERVERS
   
+  /**
+   * \brief Returns \c true if and only if the system of equations can be solved.
+   */
+  [[nodiscard]] constexpr bool solvable() const noexcept { return equations.rank == 31; }
+  
+  /**
+   * \brief Reconstructs the current internal state parities of the target generator.
+   *
+   * The system must be solvable.
+   *
+   * \return The internal state parities, ordered from oldest in the LSB to most
+   *         recent in the MSB.
+   */
+  [[nodiscard]] constexpr std::uint32_t solve_parities() const noexcept;
+  
+  /**
+   * \brief Returns the parity of a recent state, in terms of the initial system
+   *        parities.
+   *
+   * \param [in] offset The offset of the state, where `-1` is the most recent and
+   *                    `-31` is the oldest.
+   */
+  [[nodiscard]] constexpr std::uint32_t parity_at(int offset) const noexcept { return parity(offset); }
+  
   // -------------------------------------------------------------------------------
   // MODIFIERS
   
   /**
-   * \brief Feeds an output \a value from the PRNG 
+   * \brief Advances the system by one output.
+   *
+   * \return The parities which contributed to the new state.
    */
-  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept;
+  constexpr step_type advance() noexcept
+  {
+    const auto q31 = parity.at<-31>(); // p_{i-31} in terms of initial parities
+    const auto q3  = parity.at<-3>();  // p_{i-3}  in terms of initial parities
+    parity.pop_and_push(q31 ^ q3);
+    return {.lag31 = q31, .lag3 = q3};
+  }
+  
+  /**
+   * \brief Records that a carry was observed for \a step.
+   *
+   * \return \c true if the system of linear equations can be solved.
+   */
+  constexpr bool push_carry(step_type step) noexcept
+  {
+    return equations.push(step.lag31, true) || equations.push(step.lag3, true);
+  }
+  
+  /**
+   * \brief Records that the state parity given by \a coefficients, in terms of
+   *        the initial system parities, equals \a value.
+   *
+   * \return \c true if the system of linear equations can be solved.
+   */
+  constexpr bool push_parity(std::uint32_t coefficients, bool value) noexcept
+  {
+    return equations.push(coefficients, value);
+  }
   
 private:
-  cyclic_fixed_queue<value_type, 31> history;   ///< Keeps track of recent values.
-  cyclic_fixed_queue<std::uint32_t, 31> parity; ///< Parities of recent states in
-                                                ///< terms of initial system
-                                                ///< parities.
+  cyclic_fixed_queue<std::uint32_t, 31, queue_cursor::back> parity; ///< Parities of recent
+                                                                    ///< states in terms of
+                                                                    ///< initial system
+                                                                    ///< parities.
   
   struct {
     int rank = 0; ///< The rank of #matrix.
@@ -175,29 +252,50 @@ private:
       return (rank += matrix.push_row(coefficients)) == 31;
     }
   } equations;
+};
+
+class solver
+{
+public:
+  using generator_type = reference_generator; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type; 
+  
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+  
+  /** 
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  constexpr solver() noexcept = default;
+  
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+  
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+  
+  /**
+   * \brief Feeds an output \a value from the PRNG 
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept;
+  
+private:
+  typename generator_type::table_type history; ///< Keeps track of recent values.
+  parity_system parities;                      ///< Parities of recent states and 
+                                               ///< the equations over them.
   
   /**
    * \brief Reconstructs the target generator.
    *
-   * The system must be solvable, i.e. `equations.rank == 31`.
+   * The system must be solvable, i.e. `parities.solvable()`.
    *
    * \return A generator producing equivalent output to the one which fed the solver
    *         values.
    */
   [[nodiscard]] constexpr generator_type solve() noexcept;
-  
-  /**
-   * \brief Reconstructs the current internal state parities of the target generator.
-   *
-   * The system must be solvable, i.e. `equations.rank == 31`.
-   *
-   * \return The internal state parities, ordered from oldest in the LSB to most
-   *         recent in the MSB.
-   */
-  [[nodiscard]] constexpr std::uint32_t solve_parities() noexcept;
 };
 
-constexpr solver::solver() noexcept
+constexpr parity_system::parity_system() noexcept
 {
   for (int i = 0; i < 31; ++i)
     parity.push(static_cast<std::uint32_t>(1uL << i));
@@ -209,27 +307,45 @@ constexpr solver::solver() noexcept
     parity.pop_and_push(parity(-3) ^ parity(-31)); // addition, mod 2
 }
 
+constexpr std::uint32_t parity_system::solve_parities() const noexcept
+{
+  assert(solvable());
+  
+  std::uint32_t initial_state = 0;
+  for (int i = 0; i < 32; ++i) {
+    const auto row = equations.matrix[i];
+    assert(std::popcount(row) <= 2);
+    
+    initial_state |= (row >> 31) << i; // last bit indicates parity
+  }
+  
+  std::uint32_t result = 0;
+  for (int i = 0; auto coefficients : parity)
+    // this may look confusing, but it really is just multiplying the coefficients
+    // by the initial state and summing them, modulo 2, then shifting the result 
+    // into the i'th bit.
+    result |= static_cast<std::uint32_t>(std::popcount(coefficients & initial_state) % 2) << i++;
+  
+  return result;
+}
+
 constexpr auto solver::feed(value_type value) noexcept -> std::optional<generator_type>
 {
   if (history.ssize() < 31) {
     history.push(value);
-    parity.pop_and_push(parity(-3) ^ parity(-31));
+    parities.advance();
   } else {
-    const auto o31 = history(-31); // o_{i-31}
-    const auto o3  = history(-3);  // o_{i-3}
-    
-    const auto q31 = parity(-31);  // p_{i-31} in terms of initial parities
-    const auto q3  = parity(-3);   // p_{i-3}  in terms of initial parities
-    const auto q0  = q31 ^ q3;
+    const auto o31 = history.at<-31>(); // o_{i-31}
+    const auto o3  = history.at<-3>();  // o_{i-3}
     
     history.pop_and_push(value);
-    parity.pop_and_push(q0);
+    const auto step = parities.advance();
     
     const auto expected = (o31 + o3) % (1uL << 31);
     if (value != expected) {
       assert(value == (expected + 1uL));
       
-      if (equations.push(q31, true) || equations.push(q3, true))
+      if (parities.push_carry(step))
         return solve();
     }
   }
@@ -239,13 +355,11 @@ constexpr auto solver::feed(value_type value) noexcept -> std::optional<generato
 
 constexpr auto solver::solve() noexcept -> generator_type
 {
-  assert(equations.rank == 31);
-  
-  // equations.matrix.reduce();
+  assert(parities.solvable());
   
   // parity_bits ordered from oldest (LSB) to most recent (MSB)
   auto table = history;
-  for (auto parity_bits = solve_parities(); auto& state : table) {
+  for (auto parity_bits = parities.solve_parities(); auto& state : table) {
     state = (state << 1) | (parity_bits & 1u);
     parity_bits >>= 1;
   }
@@ -253,41 +367,21 @@ constexpr auto solver::solve() noexcept -> generator_type
   return generator_type{table};
 }
 
-constexpr std::uint32_t solver::solve_parities() noexcept
-{
-  assert(equations.rank == 31);
-  
-  std::uint32_t initial_state = 0;
-  for (int i = 0; i < 32; ++i) {
-    const auto row = equations.matrix[i];
-    assert(std::popcount(row) <= 2);
-    
-    initial_state |= (row >> 31) << i; // last bit indicates parity
-  }
-  
-  value_type result = 0;
-  for (int i = 0; auto coefficients : parity)
-    // this may look confusing, but it really is just multiplying the coefficients
-    // by the initial state and summing them, modulo 2, then shifting the result 
-    // into the i'th bit.
-    result |= static_cast<value_type>(std::popcount(coefficients & initial_state) % 2) << i++;
-  
-  return result;
-}
-
-constexpr auto semicanonical_b32x32::row_sum(std::uint32_t select) const noexcept
+template<std::unsigned_integral Row>
+constexpr auto semicanonical_matrix<Row>::row_sum(row_type select) const noexcept
   -> row_type
 {
   // gcc: -O3 produces good throughput
   // clang: -O2 produces good throughput (O3 is regression)
   
   row_type result = 0;
-  for (int i = 0; i < 32; ++i)
-    result ^= !!(select & (static_cast<std::uint32_t>(1) << i)) * rows_[i];
+  for (int i = 0; i < size; ++i)
+    result ^= !!(select & (static_cast<row_type>(1) << i)) * rows_[i];
   return result;
 }
 
-constexpr bool semicanonical_b32x32::push_row(row_type row) noexcept
+template<std::unsigned_integral Row>
+constexpr bool semicanonical_matrix<Row>::push_row(row_type row) noexcept
 {
   row ^= row_sum(row); // eliminate current pivots
   
@@ -295,11 +389,11 @@ constexpr bool semicanonical_b32x32::push_row(row_type row) noexcept
     return false; // nothing to add
   
   const int pivot = std::countr_zero(row);
-  assert(0 <= pivot && pivot < 32);
+  assert(0 <= pivot && pivot < size);
   assert(rows_[pivot] == 0);
   
   // gaussian elimination to remove row from all the rows
-  for (int i = 0; i < 32; ++i)
+  for (int i = 0; i < size; ++i)
     rows_[i] ^= !!(rows_[i] & (static_cast<row_type>(1) << pivot)) * row;
   rows_[pivot] = row;
   
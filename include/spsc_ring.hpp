@@ -0,0 +1,241 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_SPSC_RING_HPP
+#define PREDICTING_RANDOM_SPSC_RING_HPP
+
+// ---------------------------------------------------------------------------------
+// SPSC RING EXPLANATION
+//
+// When output is captured on one thread and solved on another, the values must be
+// handed between them. spsc_ring does so without locks for exactly one producer and
+// one consumer. Each side owns one index: the producer advances the tail once it
+// has written values, and the consumer advances the head once it has read them.
+// Each side only has to load the other side's index when its own view of the free
+// or filled space runs out.
+//
+// Values are published and consumed in batches, as at most two contiguous spans of
+// the ring's storage, so a solver with a batched feed (such as subtractive_solver
+// or mt19937_solver) can drain the ring without copying values out of it.
+//
+// IMPLEMENTATION NOTES
+// The indices count values since construction and are reduced by a mask, so the
+// capacity must be a power of two and the full ring is distinguished from the empty
+// one without a sentinel. The index written by each side shares a cache line only
+// with that side's cached copy of the other index, so the sides do not invalidate
+// each other's lines except to exchange indices.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <functional>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace predicting_random
+{
+
+/**
+ * \brief The alignment which keeps the indices of #spsc_ring on separate cache
+ *        lines.
+ */
+inline constexpr std::size_t spsc_ring_alignment = 64;
+
+/**
+ * \brief A bounded, lock-free, first-in-first-out queue between a single producer
+ *        thread and a single consumer thread.
+ *
+ * Member functions under PRODUCER may only be called by the producer, and those
+ * under CONSUMER only by the consumer. Values published by the producer are
+ * visible to the consumer once #read_segments returns them.
+ */
+template<std::semiregular T, std::size_t Capacity>
+  requires (std::has_single_bit(Capacity))
+class spsc_ring
+{
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to the empty ring.
+   */
+  spsc_ring() = default;
+
+  spsc_ring(const spsc_ring&) = delete;
+  spsc_ring& operator=(const spsc_ring&) = delete;
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the maximum number of values held by the ring.
+   */
+  [[nodiscard]] static constexpr size_type capacity() noexcept { return Capacity; }
+
+  // -------------------------------------------------------------------------------
+  // PRODUCER
+
+  /**
+   * \brief Returns the free space of the ring, in order, as at most two contiguous
+   *        ranges of storage.
+   *
+   * The head of the consumer is only loaded if fewer than \a wanted values are
+   * known to be free, so the ranges may be shorter than the actual free space.
+   * Values written to these ranges are handed to the consumer by #publish.
+   */
+  [[nodiscard]] std::array<std::span<value_type>, 2> write_segments(size_type wanted = 1) noexcept
+  {
+    const size_type tail = producer.tail.load(std::memory_order_relaxed);
+    if (Capacity - (tail - producer.head) < wanted)
+      producer.head = consumer.head.load(std::memory_order_acquire);
+
+    return ranges(storage_.data(), tail, Capacity - (tail - producer.head));
+  }
+
+  /**
+   * \brief Hands the first \a count values of the free space to the consumer.
+   */
+  void publish(size_type count) noexcept
+  {
+    const size_type tail = producer.tail.load(std::memory_order_relaxed);
+    assert(count <= Capacity - (tail - producer.head));
+    producer.tail.store(tail + count, std::memory_order_release);
+  }
+
+  /**
+   * \brief Copies as many values of \a values into the ring as fit, in order, and
+   *        hands them to the consumer.
+   *
+   * \return The number of values pushed.
+   */
+  size_type push(std::span<const value_type> values) noexcept(std::is_nothrow_copy_assignable_v<T>)
+  {
+    const auto [first, second] = write_segments(values.size());
+    const size_type count = std::min(values.size(), first.size() + second.size());
+    const size_type split = std::min(count, first.size());
+    std::copy_n(values.begin(), split, first.begin());
+    std::copy_n(values.begin() + split, count - split, second.begin());
+    publish(count);
+    return count;
+  }
+
+  /**
+   * \brief Pushes \a value if the ring is not full.
+   *
+   * \return \c true if \a value was pushed.
+   */
+  bool try_push(const value_type& value) noexcept(std::is_nothrow_copy_assignable_v<T>)
+  {
+    return push(std::span<const value_type>(&value, 1)) == 1;
+  }
+
+  // -------------------------------------------------------------------------------
+  // CONSUMER
+
+  /**
+   * \brief Returns the published values, in order, as at most two contiguous ranges
+   *        of storage.
+   *
+   * The tail of the producer is only loaded if fewer than \a wanted values are
+   * known to be published, so the ranges may omit values published since. The
+   * values remain valid until they are released by #consume.
+   */
+  [[nodiscard]] std::array<std::span<const value_type>, 2> read_segments(size_type wanted = 1) noexcept
+  {
+    const size_type head = consumer.head.load(std::memory_order_relaxed);
+    if (consumer.tail - head < wanted)
+      consumer.tail = producer.tail.load(std::memory_order_acquire);
+
+    return ranges(std::as_const(storage_).data(), head, consumer.tail - head);
+  }
+
+  /**
+   * \brief Releases the first \a count published values back to the producer.
+   */
+  void consume(size_type count) noexcept
+  {
+    const size_type head = consumer.head.load(std::memory_order_relaxed);
+    assert(count <= consumer.tail - head);
+    consumer.head.store(head + count, std::memory_order_release);
+  }
+
+  /**
+   * \brief Passes the published values to \a sink as at most two spans, in order,
+   *        and releases them.
+   *
+   * \return The number of values drained.
+   */
+  template<std::invocable<std::span<const value_type>> Sink>
+  size_type drain(Sink&& sink)
+  {
+    const auto [first, second] = read_segments(Capacity);
+    if (!first.empty())
+      std::invoke(sink, first);
+    if (!second.empty())
+      std::invoke(sink, second);
+
+    consume(first.size() + second.size());
+    return first.size() + second.size();
+  }
+
+  /**
+   * \brief Pops the first published value, if any.
+   */
+  [[nodiscard]] std::optional<value_type> try_pop()
+  {
+    const auto [first, second] = read_segments();
+    if (first.empty())
+      return std::nullopt;
+
+    std::optional<value_type> result{first.front()};
+    consume(1);
+    return result;
+  }
+
+private:
+  /**
+   * \brief Returns the \a count values starting at the unreduced index \a index as
+   *        at most two ranges of \a data.
+   */
+  template<typename U>
+  [[nodiscard]] static std::array<std::span<U>, 2> ranges(U* data, size_type index, size_type count) noexcept
+  {
+    const size_type start = index & (Capacity - 1);
+    const size_type first = std::min(count, Capacity - start);
+    return {std::span<U>(data + start, first), std::span<U>(data, count - first)};
+  }
+
+  struct alignas(spsc_ring_alignment) producer_indices
+  {
+    std::atomic<size_type> tail{0}; ///< The number of values published.
+    size_type head = 0;             ///< The last known head of the consumer.
+  };
+
+  struct alignas(spsc_ring_alignment) consumer_indices
+  {
+    std::atomic<size_type> head{0}; ///< The number of values consumed.
+    size_type tail = 0;             ///< The last known tail of the producer.
+  };
+
+  producer_indices producer;
+  consumer_indices consumer;
+  alignas(spsc_ring_alignment) std::array<T, Capacity> storage_;
+};
+
+}
+
+#endif // PREDICTING_RANDOM_SPSC_RING_HPP
@@ -0,0 +1,165 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_STREAM_FILTER_HPP
+#define PREDICTING_RANDOM_STREAM_FILTER_HPP
+
+// ---------------------------------------------------------------------------------
+// STREAM FILTER EXPLANATION
+//
+// As explained in solver.hpp, every output of glibc TYPE_3 past the 31st satisfies
+//  o_{i} - o_{i-3} - o_{i-31} (mod 2^31) in {0, 1},
+// which unrelated output satisfies with probability 2^-30 per step. A stream can
+// therefore be rejected at its first violation, and accepted after a few dozen
+// steps without one, before any solver is constructed for it. Unlike
+// classify_generator (see generator_classifier.hpp), this only answers whether a
+// stream may be TYPE_3, but does so as the values arrive.
+//
+// IMPLEMENTATION NOTES
+// type3_filter checks a single stream value by value. filter_type3_streams checks
+// many streams at once, from output laid out with one row per step and one column
+// per stream, so that each step is a branchless loop over contiguous values, which
+// is vectorized by g++ on -O3 and clang++ on -O2.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <span>
+
+#include "cyclic_fixed_queue.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief The state of a stream checked by #type3_filter.
+ */
+enum class filter_verdict
+{
+  pending,  ///< Too few values have been checked.
+  accepted, ///< The stream may be glibc TYPE_3.
+  rejected, ///< The stream is not glibc TYPE_3.
+};
+
+/**
+ * \brief Checks whether a stream may be glibc TYPE_3, value by value.
+ */
+class type3_filter
+{
+public:
+  using value_type = std::uint32_t;
+
+  /**
+   * \brief The default number of steps that must pass before a stream is accepted.
+   */
+  static constexpr int default_steps = 32;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a filter which accepts a stream once \a steps values past
+   *        the 31st satisfy the TYPE_3 relation.
+   */
+  explicit constexpr type3_filter(int steps = default_steps) noexcept : remaining(steps)
+  {
+    assert(steps > 0);
+  }
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  /**
+   * \brief Returns the verdict for the values fed so far.
+   */
+  [[nodiscard]] constexpr filter_verdict verdict() const noexcept { return verdict_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value of the stream.
+   *
+   * Once the verdict is no longer #filter_verdict::pending, further values are
+   * ignored.
+   *
+   * \return The verdict after \a value.
+   */
+  constexpr filter_verdict feed(value_type value) noexcept
+  {
+    if (verdict_ != filter_verdict::pending)
+      return verdict_;
+
+    if (history.ssize() < 31) {
+      history.push(value);
+      return verdict_;
+    }
+
+    const value_type delta = (value - history(-3) - history(-31)) & 0x7FFF'FFFFu;
+    history.pop_and_push(value);
+
+    if (delta > 1u)
+      verdict_ = filter_verdict::rejected;
+    else if (--remaining == 0)
+      verdict_ = filter_verdict::accepted;
+
+    return verdict_;
+  }
+
+private:
+  cyclic_fixed_queue<value_type, 31> history; ///< Keeps track of recent values.
+  int remaining;                              ///< Steps left before acceptance.
+  filter_verdict verdict_ = filter_verdict::pending;
+};
+
+/**
+ * \brief Checks whether each of several streams may be glibc TYPE_3.
+ *
+ * \param [in]  outputs Consecutive output of \a passed.size() streams, where the
+ *                      value at `outputs[i * passed.size() + k]` is the `i`th
+ *                      output of stream `k`.
+ * \param [out] passed  Set to `1` for each stream without violations of the TYPE_3
+ *                      relation, and to `0` otherwise.
+ *
+ * \return The number of streams that passed.
+ */
+inline std::size_t filter_type3_streams(
+  std::span<const std::uint32_t> outputs,
+  std::span<std::uint8_t>        passed) noexcept
+{
+  const std::size_t streams = passed.size();
+  if (streams == 0)
+    return 0;
+
+  assert(outputs.size() % streams == 0);
+  const std::size_t steps = outputs.size() / streams;
+  assert(steps > 31);
+
+  std::fill(passed.begin(), passed.end(), std::uint8_t(1));
+  std::uint8_t* ok = passed.data();
+  for (std::size_t i = 31; i < steps; ++i) {
+    const std::uint32_t* o   = outputs.data() + i * streams;
+    const std::uint32_t* o3  = o - 3 * streams;
+    const std::uint32_t* o31 = o - 31 * streams;
+
+    std::uint8_t any = 0;
+    for (std::size_t k = 0; k < streams; ++k) {
+      ok[k] &= ((o[k] - o3[k] - o31[k]) & 0x7FFF'FFFFu) <= 1u;
+      any |= ok[k];
+    }
+
+    if (!any)
+      break; // every stream has been rejected
+  }
+
+  return static_cast<std::size_t>(std::count(passed.begin(), passed.end(), std::uint8_t(1)));
+}
+
+}
+
+#endif // PREDICTING_RANDOM_STREAM_FILTER_HPP
@@ -0,0 +1,478 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PREDICTING_RANDOM_SUBTRACTIVE_SOLVER_HPP
+#define PREDICTING_RANDOM_SUBTRACTIVE_SOLVER_HPP
+
+// ---------------------------------------------------------------------------------
+// SUBTRACTIVE SOLVER EXPLANATION
+//
+// Knuth's subtractive generator follows
+//  x_{i} := x_{i-55} - x_{i-24} (mod M),
+// and comes in two common families:
+//  * M below 2^31, where each output is an entire word x_{i}, such as Numerical
+//    Recipes' ran3 (M = 10^9, output divided by M) or the M = 2^31 - 1 variant;
+//    and,
+//  * M = 2^32, where, as with glibc random(), the output o_{i} = x_{i} >> 1 drops
+//    the LSB.
+//
+// The first family hides nothing, so 55 consecutive outputs are its state.
+//
+// The second variant is solved as TYPE_3 is (see solver.hpp). Writing
+// x_{i} = 2 * o_{i} + p_{i}, it is quickly verified that
+//  o_{i} = o_{i-55} - o_{i-24} - (1 - p_{i-55}) * p_{i-24} (mod 2^31),
+// so a borrow event, where the last term is 1, indicates
+//  p_{i-55} = 0 and p_{i-24} = 1,
+// while the parities otherwise follow p_{i} = p_{i-55} + p_{i-24} (mod 2). The
+// parities of the first 55 outputs are the unknowns of the system, and since 55
+// unknowns and the constant do not fit in 32 bits, the equations are kept in a
+// semicanonical_b64x64.
+//
+// IMPLEMENTATION NOTES
+// The batched overload of feed() first tests a block of output for borrow events
+// in a branchless loop over contiguous values, which gcc and clang vectorize at -O2
+// and above, and only then walks the block to update the parities. About a quarter
+// of the steps are borrow events, so a few hundred outputs suffice.
+// ---------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <optional>
+#include <span>
+
+#include "cyclic_fixed_queue.hpp"
+#include "solver.hpp"
+
+namespace predicting_random
+{
+
+/**
+ * \brief A generator which produces output equivalent to Knuth's subtractive
+ *        generator modulo \a Modulus, seeded by the procedure of Numerical
+ *        Recipes' ran3 with \a Modulus in place of `MBIG`.
+ *
+ * This type satisfies the concept `std::uniform_random_bit_generator`.
+ */
+template<std::uint32_t Modulus>
+  requires (161803398u < Modulus && Modulus <= 2147483647u)
+class basic_knuth_subtractive_generator
+{
+public:
+  using result_type = std::uint32_t;
+  using table_type  = cyclic_fixed_queue<result_type, 55>;
+
+  static constexpr result_type modulus = Modulus;
+  static constexpr result_type seed_constant = 161803398u; ///< `MSEED` of ran3.
+
+  static constexpr result_type min() noexcept { return 0; }
+  static constexpr result_type max() noexcept { return modulus - 1u; }
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Initializes the generator using \a seed, as by ran3.
+   */
+  explicit constexpr basic_knuth_subtractive_generator(std::int32_t seed) noexcept
+    : queue_(table_from_seed(seed)) {}
+
+  /**
+   * \brief Initializes the internal state directly from \a table, ordered from
+   *        oldest to most recent word.
+   */
+  explicit constexpr basic_knuth_subtractive_generator(const table_type& table) noexcept
+    : queue_(table) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const basic_knuth_subtractive_generator&, const basic_knuth_subtractive_generator&) = default;
+
+  /**
+   * \brief Returns the next output value.
+   */
+  [[nodiscard]] constexpr result_type peek() const noexcept
+  {
+    const result_type x55 = queue_(-55);
+    const result_type x24 = queue_(-24);
+    return x55 >= x24 ? x55 - x24 : x55 - x24 + modulus;
+  }
+
+  /**
+   * \brief Returns a reference to the internal state.
+   */
+  [[nodiscard]] constexpr const table_type& table() const noexcept { return queue_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type advance() noexcept { return queue_.pop_and_push(peek()); }
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type operator()() noexcept { return advance(); }
+
+private:
+  table_type queue_;
+
+  /**
+   * \brief Returns internal state for a generator using \a seed.
+   */
+  [[nodiscard]] static constexpr table_type table_from_seed(std::int32_t seed) noexcept;
+};
+
+template<std::uint32_t Modulus>
+  requires (161803398u < Modulus && Modulus <= 2147483647u)
+constexpr auto basic_knuth_subtractive_generator<Modulus>::table_from_seed(std::int32_t seed) noexcept
+  -> table_type
+{
+  constexpr std::int64_t m = modulus;
+  const auto abs = [](std::int64_t value) { return value < 0 ? -value : value; };
+
+  // ma[1..55] of ran3
+  std::array<std::int64_t, 56> ma{};
+  std::int64_t mj = abs(seed_constant - abs(seed)) % m;
+  std::int64_t mk = 1;
+  ma[55] = mj;
+  for (int i = 1; i < 55; ++i) {
+    const int ii = (21 * i) % 55;
+    ma[ii] = mk;
+    mk = mj - mk;
+    if (mk < 0)
+      mk += m;
+    mj = ma[ii];
+  }
+
+  for (int k = 1; k < 5; ++k) {
+    for (int i = 1; i < 56; ++i) {
+      ma[i] -= ma[1 + (i + 30) % 55];
+      if (ma[i] < 0)
+        ma[i] += m;
+    }
+  }
+
+  table_type result;
+  for (int i = 1; i < 56; ++i)
+    result.push(static_cast<result_type>(ma[i]));
+
+  return result;
+}
+
+/**
+ * \brief Knuth's subtractive generator modulo `2^31 - 1`.
+ */
+using knuth_subtractive_generator = basic_knuth_subtractive_generator<2147483647u>;
+
+/**
+ * \brief The generator of Numerical Recipes' ran3, modulo `MBIG = 10^9`.
+ *
+ * ran3 returns each output divided by `MBIG`; this generator returns the output
+ * itself.
+ */
+using ran3_generator = basic_knuth_subtractive_generator<1000000000u>;
+
+/**
+ * \brief A generator which produces output equivalent to Knuth's subtractive
+ *        generator modulo `2^32`, where each output drops the LSB of the state.
+ *
+ * This type satisfies the concept `std::uniform_random_bit_generator`.
+ */
+class subtractive_generator
+{
+public:
+  using result_type = std::uint32_t;
+  using table_type  = cyclic_fixed_queue<result_type, 55>;
+
+  static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+  static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max() >> 1; }
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Initializes the internal state directly from \a table, ordered from
+   *        oldest to most recent word.
+   */
+  explicit constexpr subtractive_generator(const table_type& table) noexcept : queue_(table) {}
+
+  // -------------------------------------------------------------------------------
+  // OBSERVERS
+
+  friend constexpr bool operator==(const subtractive_generator&, const subtractive_generator&) = default;
+
+  /**
+   * \brief Returns the next internal state value.
+   */
+  [[nodiscard]] constexpr result_type peek_state() const noexcept { return queue_(-55) - queue_(-24); }
+
+  /**
+   * \brief Returns the next output value.
+   */
+  [[nodiscard]] constexpr result_type peek() const noexcept { return peek_state() >> 1; }
+
+  /**
+   * \brief Returns a reference to the internal state.
+   */
+  [[nodiscard]] constexpr const table_type& table() const noexcept { return queue_; }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type advance() noexcept { return queue_.pop_and_push(peek_state()) >> 1; }
+
+  /**
+   * \brief Generates a pseudo-random value, advancing the state by one position.
+   */
+  constexpr result_type operator()() noexcept { return advance(); }
+
+private:
+  table_type queue_;
+};
+
+/**
+ * \brief A solver for #basic_knuth_subtractive_generator modulo \a Modulus.
+ */
+template<std::uint32_t Modulus>
+class basic_knuth_subtractive_solver
+{
+public:
+  using generator_type = basic_knuth_subtractive_generator<Modulus>; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  constexpr basic_knuth_subtractive_solver() noexcept = default;
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value from the PRNG.
+   *
+   * \return A generator positioned after \a value, once 55 outputs have been fed.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept
+  {
+    assert(value <= generator_type::max());
+    if (history.ssize() < 55)
+      history.push(value);
+    else
+      history.pop_and_push(value);
+
+    if (history.ssize() < 55)
+      return std::nullopt;
+
+    return generator_type{history};
+  }
+
+  /**
+   * \brief Feeds consecutive output \a values from the PRNG.
+   *
+   * \return A generator positioned after the last value, once 55 outputs have
+   *         been fed.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(std::span<const value_type> values) noexcept
+  {
+    // only the last 55 values can contribute to the state
+    std::optional<generator_type> result;
+    for (const auto value : values.last(std::min<std::size_t>(values.size(), 55)))
+      result = feed(value);
+    return result;
+  }
+
+private:
+  typename generator_type::table_type history; ///< Keeps track of recent values.
+};
+
+/**
+ * \brief A solver for #knuth_subtractive_generator.
+ */
+using knuth_subtractive_solver = basic_knuth_subtractive_solver<2147483647u>;
+
+/**
+ * \brief A solver for #ran3_generator.
+ */
+using ran3_solver = basic_knuth_subtractive_solver<1000000000u>;
+
+/**
+ * \brief A solver for #subtractive_generator.
+ */
+class subtractive_solver
+{
+public:
+  using generator_type = subtractive_generator; ///< The targeted generator type.
+  using value_type = typename generator_type::result_type;
+
+  // -------------------------------------------------------------------------------
+  // CONSTRUCTORS
+
+  /**
+   * \brief Constructs to a solver that is ready to be fed output.
+   */
+  constexpr subtractive_solver() noexcept
+  {
+    for (int i = 0; i < 55; ++i)
+      parity.push(std::uint64_t(1) << i);
+  }
+
+  // -------------------------------------------------------------------------------
+  // MODIFIERS
+
+  /**
+   * \brief Feeds an output \a value from the PRNG.
+   *
+   * \return A generator positioned after \a value, once the state is determined.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(value_type value) noexcept;
+
+  /**
+   * \brief Feeds consecutive output \a values from the PRNG.
+   *
+   * \return A generator positioned after the last value, once the state is
+   *         determined.
+   */
+  [[nodiscard]] constexpr std::optional<generator_type> feed(std::span<const value_type> values) noexcept;
+
+private:
+  static constexpr std::uint64_t constant_bit = std::uint64_t(1) << 63;
+
+  int fed = 0;                                  ///< The number of values fed, up to 55.
+  typename generator_type::table_type history;  ///< Keeps track of recent values.
+  cyclic_fixed_queue<std::uint64_t, 55> parity; ///< Parities of recent states in
+                                                ///< terms of the parities of the
+                                                ///< first 55 outputs.
+  int rank = 0;                                 ///< The rank of #equations.
+  semicanonical_b64x64 equations {};
+
+  /**
+   * \brief Advances the parities by one output, for which a borrow was observed
+   *        if \a borrow is \c true.
+   *
+   * \return \c true if the system of linear equations can be solved.
+   */
+  constexpr bool step(bool borrow) noexcept
+  {
+    const auto q55 = parity(-55); // p_{i-55} in terms of initial parities
+    const auto q24 = parity(-24); // p_{i-24} in terms of initial parities
+    parity.pop_and_push(q55 ^ q24);
+
+    return borrow
+      && ((rank += equations.push_row(q55)) == 55
+          || (rank += equations.push_row(q24 | constant_bit)) == 55);
+  }
+
+  /**
+   * \brief Reconstructs the target generator.
+   *
+   * \return A generator producing equivalent output to the one which fed the solver
+   *         values.
+   */
+  [[nodiscard]] constexpr generator_type solve() const noexcept;
+};
+
+constexpr auto subtractive_solver::feed(value_type value) noexcept -> std::optional<generator_type>
+{
+  assert(value <= generator_type::max());
+
+  if (fed < 55) {
+    history.push(value);
+    ++fed;
+    return std::nullopt;
+  }
+
+  const auto expected = (history(-55) - history(-24)) & generator_type::max();
+  history.pop_and_push(value);
+  assert(value == expected || value == ((expected - 1u) & generator_type::max()));
+
+  if (step(value != expected))
+    return solve();
+
+  return std::nullopt;
+}
+
+constexpr auto subtractive_solver::feed(std::span<const value_type> values) noexcept
+  -> std::optional<generator_type>
+{
+  const auto finish = [&values](generator_type gen, std::size_t i) {
+    for (++i; i < values.size(); ++i) {
+      [[maybe_unused]] const auto value = gen();
+      assert(value == values[i]);
+    }
+    return gen;
+  };
+
+  // the lags of the first 55 values may lie in history
+  std::size_t i = 0;
+  for (; i < values.size() && i < 55; ++i) {
+    if (auto result = feed(values[i]))
+      return finish(*result, i);
+  }
+
+  constexpr std::size_t block_size = 256;
+  std::array<std::uint8_t, block_size> borrow;
+  while (i < values.size()) {
+    const std::size_t count = std::min(block_size, values.size() - i);
+    const value_type* o   = values.data() + i;
+    const value_type* o55 = o - 55;
+    const value_type* o24 = o - 24;
+
+    for (std::size_t k = 0; k < count; ++k)
+      borrow[k] = ((o55[k] - o24[k] - o[k]) & generator_type::max()) != 0;
+
+    for (std::size_t k = 0; k < count; ++k) {
+      if (step(borrow[k])) {
+        history.pop_and_push_n(std::span(o, k + 1));
+        return finish(solve(), i + k);
+      }
+    }
+
+    history.pop_and_push_n(std::span(o, count));
+    i += count;
+  }
+
+  return std::nullopt;
+}
+
+constexpr auto subtractive_solver::solve() const noexcept -> generator_type
+{
+  assert(rank == 55);
+
+  std::uint64_t initial_state = 0;
+  for (int i = 0; i < 55; ++i) {
+    const auto row = equations[i];
+    assert(std::popcount(row) <= 2);
+
+    initial_state |= (row >> 63) << i; // last bit indicates parity
+  }
+
+  auto table = history;
+  for (auto it = parity.begin(); auto& state : table) {
+    const auto p = static_cast<value_type>(std::popcount(*it++ & initial_state) % 2);
+    state = (state << 1) | p;
+  }
+
+  return generator_type{table};
+}
+
+}
+
+#endif // PREDICTING_RANDOM_SUBTRACTIVE_SOLVER_HPP
@@ -0,0 +1,321 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+// ---------------------------------------------------------------------------------
+// RANDOM PRELOAD EXPLANATION
+//
+// This library replaces glibc random(), srandom(), rand(), srand(), initstate() and
+// setstate() with implementations that produce identical output, for preloading
+// into existing binaries through LD_PRELOAD.
+//
+// glibc computes one value per call under a lock. Here, while the state is TYPE_3
+// (the default, and the type chosen by initstate() for 128 to 255 bytes of state),
+// values are generated in blocks by a reference_generator, and each call only takes
+// the next value of the block under the lock. The other types are rare and are
+// stepped one value per call, exactly as glibc does.
+//
+// State buffers keep the layout used by glibc: the first word encodes the type and
+// the position of the rear pointer, followed by the words of the state. A buffer is
+// brought up to date when it is switched away from by initstate() or setstate(),
+// which is when glibc writes its first word, so buffers saved and restored by a
+// program continue the same sequences. While a TYPE_3 buffer is current, however,
+// its words are not updated by each call, unlike glibc.
+// ---------------------------------------------------------------------------------
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "prng.hpp"
+
+namespace
+{
+
+using predicting_random::basic_reference_generator;
+using predicting_random::reference_generator;
+using predicting_random::reference_table;
+using predicting_random::sliding_window_backend;
+
+constexpr int max_types = 5;
+constexpr int type_3    = 3;
+constexpr std::array<int, max_types> degrees     = {0, 7, 15, 31, 63};
+constexpr std::array<int, max_types> separations = {0, 3, 1, 3, 1};
+
+/**
+ * \brief The number of values generated at a time for TYPE_3.
+ */
+constexpr std::size_t block_size = 256;
+
+/**
+ * \brief A lock for the short critical sections of this library, which is
+ *        constant-initialized so that it may be used before static initialization.
+ */
+class spin_lock
+{
+public:
+  void lock() noexcept
+  {
+    while (flag.test_and_set(std::memory_order_acquire)) {
+      while (flag.test(std::memory_order_relaxed))
+        std::this_thread::yield();
+    }
+  }
+
+  void unlock() noexcept { flag.clear(std::memory_order_release); }
+
+private:
+  std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+
+/**
+ * \brief The state of the glibc `random()` family of functions.
+ */
+class random_state
+{
+public:
+  constexpr random_state() noexcept : buffer(default_buffer.data()) { default_buffer[0] = type_3; }
+
+  /**
+   * \brief Returns the next value, as by `random()`.
+   */
+  std::int32_t next() noexcept
+  {
+    if (type == type_3) {
+      if (index == block_size)
+        generate_block();
+      return static_cast<std::int32_t>(block[index++]);
+    }
+
+    return next_stepped();
+  }
+
+  /**
+   * \brief Seeds the current state with \a seed, as by `srandom()`.
+   */
+  void seed(unsigned seed) noexcept;
+
+  /**
+   * \brief Brings the current buffer up to date and returns it.
+   */
+  std::int32_t* save() noexcept;
+
+  /**
+   * \brief Makes \a new_buffer of \a size bytes current and seeds it with \a seed,
+   *        as by `initstate()`.
+   *
+   * \return \c false if \a size is too small, in which case the state is unchanged.
+   */
+  bool initialize(unsigned seed, std::int32_t* new_buffer, std::size_t size) noexcept;
+
+  /**
+   * \brief Makes \a new_buffer current, as by `setstate()`.
+   *
+   * \return \c false if \a new_buffer holds no valid type, in which case the
+   *         state is unchanged.
+   */
+  bool restore(std::int32_t* new_buffer) noexcept;
+
+private:
+  std::array<std::int32_t, 1 + 31> default_buffer{};
+  std::int32_t* buffer; ///< The current buffer, starting with the encoded type.
+  int type = type_3;
+  int rear = 0;  ///< The index of the rear pointer in the state, if not TYPE_3.
+  int front = 0; ///< The index of the front pointer in the state, if not TYPE_3.
+
+  basic_reference_generator<sliding_window_backend<block_size>> gen{1u};
+  std::array<std::uint32_t, 31> block_start{}; ///< The table of #gen before #block.
+  std::array<std::uint32_t, block_size> block{};
+  std::size_t index = block_size;              ///< The index of the next value of #block.
+
+  std::int32_t* words() noexcept { return buffer + 1; }
+
+  void generate_block() noexcept
+  {
+    std::ranges::copy(gen.table(), block_start.begin());
+    for (auto& value : block)
+      value = gen();
+    index = 0;
+  }
+
+  /**
+   * \brief Returns the next value of a type other than TYPE_3.
+   */
+  std::int32_t next_stepped() noexcept
+  {
+    std::int32_t* state = words();
+    if (type == 0)
+      return state[0] = static_cast<std::int32_t>((static_cast<std::uint32_t>(state[0]) * 1103515245u + 12345u) & 0x7FFF'FFFFu);
+
+    const auto value = static_cast<std::uint32_t>(state[front]) + static_cast<std::uint32_t>(state[rear]);
+    state[front] = static_cast<std::int32_t>(value);
+    front = (front + 1) % degrees[type];
+    rear  = (rear + 1) % degrees[type];
+    return static_cast<std::int32_t>(value >> 1);
+  }
+};
+
+void random_state::seed(unsigned seed) noexcept
+{
+  if (seed == 0)
+    seed = 1;
+
+  if (type == type_3) {
+    gen = decltype(gen){seed};
+    index = block_size;
+    return;
+  }
+
+  std::int32_t* state = words();
+  state[0] = static_cast<std::int32_t>(seed);
+  if (type == 0)
+    return;
+
+  for (int i = 1; i < degrees[type]; ++i) {
+    auto word = (16807LL * state[i - 1]) % 2147483647;
+    if (word < 0)
+      word += 2147483647;
+    state[i] = static_cast<std::int32_t>(word);
+  }
+
+  rear = 0;
+  front = separations[type];
+  for (int i = 0; i < 10 * degrees[type]; ++i)
+    next_stepped();
+}
+
+std::int32_t* random_state::save() noexcept
+{
+  if (type != type_3) {
+    buffer[0] = type == 0 ? 0 : max_types * rear + type;
+    return buffer;
+  }
+
+  // the state as of the values taken, with the rear pointer at the first word
+  reference_table table;
+  if (index == block_size) {
+    table = gen.table();
+  } else {
+    reference_table start;
+    start.push_range(block_start);
+    reference_generator taken{start};
+    taken.discard(index);
+    table = taken.table();
+  }
+
+  std::int32_t* state = words();
+  for (int k = 0; const auto word : table)
+    state[(separations[type_3] + k++) % 31] = static_cast<std::int32_t>(word);
+  buffer[0] = type_3;
+  return buffer;
+}
+
+bool random_state::initialize(unsigned seed, std::int32_t* new_buffer, std::size_t size) noexcept
+{
+  int new_type;
+  if (size >= 128)
+    new_type = size < 256 ? 3 : 4;
+  else if (size >= 32)
+    new_type = size < 64 ? 1 : 2;
+  else if (size >= 8)
+    new_type = 0;
+  else
+    return false;
+
+  save();
+  buffer = new_buffer;
+  type = new_type;
+  this->seed(seed);
+  save();
+  return true;
+}
+
+bool random_state::restore(std::int32_t* new_buffer) noexcept
+{
+  const int new_type = new_buffer[0] % max_types;
+  if (new_type < 0)
+    return false;
+
+  save();
+  buffer = new_buffer;
+  type = new_type;
+  if (type == 0)
+    return true;
+
+  rear = buffer[0] / max_types;
+  front = (rear + separations[type]) % degrees[type];
+  if (type != type_3)
+    return true;
+
+  reference_table table;
+  const std::int32_t* state = words();
+  for (int k = 0; k < 31; ++k)
+    table.push(static_cast<std::uint32_t>(state[(front + k) % 31]));
+  gen = decltype(gen){table};
+  index = block_size;
+  return true;
+}
+
+constinit spin_lock    state_lock;
+constinit random_state state;
+
+}
+
+extern "C"
+{
+
+[[gnu::visibility("default")]] long random() noexcept
+{
+  std::scoped_lock lock(state_lock);
+  return state.next();
+}
+
+[[gnu::visibility("default")]] void srandom(unsigned seed) noexcept
+{
+  std::scoped_lock lock(state_lock);
+  state.seed(seed);
+}
+
+[[gnu::visibility("default")]] int rand() noexcept
+{
+  return static_cast<int>(random());
+}
+
+[[gnu::visibility("default")]] void srand(unsigned seed) noexcept
+{
+  srandom(seed);
+}
+
+[[gnu::visibility("default")]] char* initstate(unsigned seed, char* arg_state, std::size_t n) noexcept
+{
+  std::scoped_lock lock(state_lock);
+  std::int32_t* const old_state = state.save();
+  if (!state.initialize(seed, reinterpret_cast<std::int32_t*>(arg_state), n)) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  return reinterpret_cast<char*>(old_state);
+}
+
+[[gnu::visibility("default")]] char* setstate(char* arg_state) noexcept
+{
+  std::scoped_lock lock(state_lock);
+  std::int32_t* const old_state = state.save();
+  if (!state.restore(reinterpret_cast<std::int32_t*>(arg_state))) {
+    errno = EINVAL;
+    return nullptr;
+  }
+
+  return reinterpret_cast<char*>(old_state);
+}
+
+}
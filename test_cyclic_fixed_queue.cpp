@@ -0,0 +1,208 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+// USAGE: (program)
+// Verifies that cyclic_fixed_queue behaves as a std::deque bounded by its capacity,
+// for each cursor and storage mode.
+//
+// A fixed sequence of pushes and pops, single and in bulk, is applied to both, and
+// after each operation every accessor of the queue is compared against the deque:
+// relative offsets, compile-time lag accessors, iterators and their arithmetic,
+// segments and, for mirrored storage, contiguous windows. Capacities with and
+// without a power-of-two storage size are checked.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "cyclic_fixed_queue.hpp"
+
+namespace
+{
+  using namespace predicting_random;
+
+  /**
+   * \brief Returns \c true if every accessor of \a queue agrees with \a model.
+   */
+  template<typename Queue>
+  bool matches(const Queue& queue, const std::deque<int>& model);
+
+  /**
+   * \brief Returns \c true if a queue of \a Capacity, \a Cursor and \a Storage
+   *        agrees with a deque over the sequence of operations, reporting
+   *        mismatches as \a name.
+   */
+  template<std::size_t Capacity, queue_cursor Cursor, queue_storage Storage>
+  bool check_queue(const char* name);
+}
+
+int main()
+{
+  using enum queue_cursor;
+  using enum queue_storage;
+
+  bool passed = true;
+  passed &= check_queue<7, front, single>("<7, front, single>");
+  passed &= check_queue<7, back, single>("<7, back, single>");
+  passed &= check_queue<7, front, mirrored>("<7, front, mirrored>");
+  passed &= check_queue<7, back, mirrored>("<7, back, mirrored>");
+  passed &= check_queue<10, front, single>("<10, front, single>");
+  passed &= check_queue<10, back, single>("<10, back, single>");
+  passed &= check_queue<10, front, mirrored>("<10, front, mirrored>");
+  passed &= check_queue<10, back, mirrored>("<10, back, mirrored>");
+
+  if (!passed)
+    return EXIT_FAILURE;
+
+  std::printf("%s\n", "cyclic_fixed_queue matches std::deque for every mode");
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+  template<typename Queue>
+  bool matches(const Queue& queue, const std::deque<int>& model)
+  {
+    const auto n = static_cast<std::ptrdiff_t>(model.size());
+    if (queue.size() != model.size() || queue.empty() != model.empty())
+      return false;
+
+    // offsets from the front and from the back
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+      if (queue(i) != model[i] || queue(i - n) != model[i])
+        return false;
+    }
+
+    if (n > 0) {
+      if (queue.front() != model.front() || queue.back() != model.back())
+        return false;
+      if (queue.template at<0>() != model.front() || queue.template at<-1>() != model.back())
+        return false;
+    }
+
+    // iterators, in both directions, and their arithmetic
+    if (!std::equal(queue.begin(), queue.end(), model.begin(), model.end()))
+      return false;
+    if (!std::equal(queue.rbegin(), queue.rend(), model.rbegin(), model.rend()))
+      return false;
+    if (queue.end() - queue.begin() != n || queue.cend() - queue.cbegin() != n)
+      return false;
+    for (std::ptrdiff_t i = 0; i < n; ++i) {
+      if (queue.begin()[i] != model[i] || *(queue.end() - (n - i)) != model[i])
+        return false;
+    }
+
+    // segments, joined in order
+    const auto [first, second] = queue.segments();
+    std::vector<int> joined(first.begin(), first.end());
+    joined.insert(joined.end(), second.begin(), second.end());
+    if (!std::equal(joined.begin(), joined.end(), model.begin(), model.end()))
+      return false;
+
+    if constexpr (requires { queue.contiguous(); }) {
+      if (!second.empty())
+        return false;
+
+      const auto all = queue.contiguous();
+      if (!std::equal(all.begin(), all.end(), model.begin(), model.end()))
+        return false;
+
+      for (std::ptrdiff_t i = 0; i < n; ++i) {
+        const auto count = static_cast<std::size_t>(n - i);
+        const auto window = queue.window(i, count);
+        if (!std::equal(window.begin(), window.end(), model.begin() + i, model.end()))
+          return false;
+        if (queue.window(i - n, count).data() != window.data())
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+  template<std::size_t Capacity, queue_cursor Cursor, queue_storage Storage>
+  bool check_queue(const char* name)
+  {
+    cyclic_fixed_queue<int, Capacity, Cursor, Storage> queue;
+    std::deque<int> model;
+    std::minstd_rand choice(static_cast<unsigned>(Capacity));
+    int next = 0;
+
+    if (!matches(queue, model)) {
+      std::printf("%s: the empty queue differs\n", name);
+      return false;
+    }
+
+    for (int step = 0; step < 5000; ++step) {
+      const std::size_t free = Capacity - model.size();
+      const int operation = static_cast<int>(choice() % 6);
+      switch (operation) {
+      case 0: // push
+        if (free > 0) {
+          queue.push(next);
+          model.push_back(next++);
+        }
+        break;
+
+      case 1: // pop
+        if (!model.empty()) {
+          queue.pop();
+          model.pop_front();
+        }
+        break;
+
+      case 2: // pop_and_push
+        if (!model.empty()) {
+          queue.pop_and_push(next);
+          model.pop_front();
+          model.push_back(next++);
+        }
+        break;
+
+      case 3: { // pop_n
+        const std::size_t count = choice() % (model.size() + 1);
+        queue.pop_n(count);
+        model.erase(model.begin(), model.begin() + static_cast<std::ptrdiff_t>(count));
+        break;
+      }
+
+      case 4: { // push_range
+        std::vector<int> values(choice() % (free + 1));
+        for (auto& value : values)
+          value = next++;
+        queue.push_range(values);
+        model.insert(model.end(), values.begin(), values.end());
+        break;
+      }
+
+      case 5: // pop_and_push_n, possibly with more values than the queue holds
+        if (!model.empty()) {
+          std::vector<int> values(choice() % (2 * Capacity + 1));
+          for (auto& value : values)
+            value = next++;
+          queue.pop_and_push_n(values);
+          for (const auto value : values) {
+            model.pop_front();
+            model.push_back(value);
+          }
+        }
+        break;
+      }
+
+      if (!matches(queue, model)) {
+        std::printf("%s: differs after operation %d at step %d\n", name, operation, step);
+        return false;
+      }
+    }
+
+    return true;
+  }
+}
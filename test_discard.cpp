@@ -0,0 +1,100 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+// USAGE: (program)
+// Verifies that basic_reference_generator::discard() leaves the generator in the
+// same state as stepping it by as many outputs, for each backend.
+//
+// Distances below 8192 are stepped by discard() itself, while longer distances are
+// jumped through the characteristic polynomial, so both sides of the threshold are
+// checked. Each generator is also advanced by a few outputs beforehand, so that the
+// jump does not start from the beginning of a block of the sliding window.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <array>
+
+#include "prng.hpp"
+
+namespace
+{
+  using namespace predicting_random;
+
+  /**
+   * \brief Returns \c true if discarding \a count outputs after \a lead outputs
+   *        from the generator seeded by \a seed matches stepping, with \a Backend.
+   */
+  template<typename Backend>
+  bool discard_matches_stepping(unsigned seed, unsigned lead, unsigned long long count);
+
+  /**
+   * \brief Returns \c true if #discard_matches_stepping holds for every tested
+   *        distance, with \a Backend, reporting mismatches as \a backend_name.
+   */
+  template<typename Backend>
+  bool check_backend(const char* backend_name);
+}
+
+int main()
+{
+  bool passed = true;
+  passed &= check_backend<ring_backend>("ring_backend");
+  passed &= check_backend<sliding_window_backend<>>("sliding_window_backend<>");
+  passed &= check_backend<sliding_window_backend<32>>("sliding_window_backend<32>");
+
+  if (!passed)
+    return EXIT_FAILURE;
+
+  std::printf("%s\n", "discard() matches stepping for every backend");
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+  template<typename Backend>
+  bool discard_matches_stepping(unsigned seed, unsigned lead, unsigned long long count)
+  {
+    basic_reference_generator<Backend> stepped(seed);
+    for (unsigned i = 0; i < lead; ++i)
+      stepped.advance();
+
+    basic_reference_generator<Backend> jumped = stepped;
+    for (unsigned long long i = 0; i < count; ++i)
+      stepped.advance();
+    jumped.discard(count);
+
+    if (reference_generator(stepped) != reference_generator(jumped))
+      return false;
+
+    for (int i = 0; i < 1000; ++i) {
+      if (stepped() != jumped())
+        return false;
+    }
+
+    return true;
+  }
+
+  template<typename Backend>
+  bool check_backend(const char* backend_name)
+  {
+    // distances on both sides of the threshold at 8192
+    constexpr std::array<unsigned long long, 12> counts = {
+      0, 1, 2, 30, 31, 500, 1024, 8191, 8192, 8193, 65543, 1'000'003};
+    constexpr std::array<unsigned, 3> leads = {0, 7, 300};
+
+    bool passed = true;
+    for (const auto count : counts) {
+      for (const auto lead : leads) {
+        if (!discard_matches_stepping<Backend>(12345u + lead, lead, count)) {
+          std::printf("%s: discard(%llu) after %u outputs differs from stepping\n", backend_name, count, lead);
+          passed = false;
+        }
+      }
+    }
+
+    return passed;
+  }
+}
@@ -0,0 +1,231 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+// USAGE: (program)
+// Verifies that the functions of the preload library (see random_preload.cpp)
+// produce the same sequences as those of glibc.
+//
+// This program is linked against the preload library, so the functions it calls
+// by name are the replacements, while the originals are looked up in glibc. The
+// same scenario is run against both and its logs are compared. The scenario
+// covers every state type, seed 0, failing initstate() and setstate(), and
+// switching between buffers, including a copied buffer.
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <vector>
+
+#include <dlfcn.h>
+
+namespace
+{
+  /**
+   * \brief The functions of the `random()` family.
+   */
+  struct random_functions
+  {
+    long  (*random)();
+    void  (*srandom)(unsigned);
+    int   (*rand)();
+    void  (*srand)(unsigned);
+    char* (*initstate)(unsigned, char*, std::size_t);
+    char* (*setstate)(char*);
+  };
+
+  /**
+   * \brief Runs the scenario against \a fn, returning its log.
+   */
+  std::vector<long long> run_scenario(const random_functions& fn);
+
+  /**
+   * \brief Returns the functions of glibc, or \c false if they cannot be found.
+   */
+  bool load_glibc(random_functions& fn);
+}
+
+int main()
+{
+  random_functions glibc;
+  if (!load_glibc(glibc)) {
+    std::printf("failed to look up the glibc functions: %s\n", dlerror());
+    return EXIT_FAILURE;
+  }
+
+  const random_functions preload{
+    .random = &::random, .srandom = &::srandom,
+    .rand = &::rand, .srand = &::srand,
+    .initstate = &::initstate, .setstate = &::setstate};
+  if (preload.random == glibc.random) {
+    std::printf("%s\n", "the preload library does not replace random()");
+    return EXIT_FAILURE;
+  }
+
+  const auto expected = run_scenario(glibc);
+  const auto actual = run_scenario(preload);
+  for (std::size_t i = 0; i < std::min(expected.size(), actual.size()); ++i) {
+    if (expected[i] != actual[i]) {
+      std::printf("entry %zu differs: glibc %lld, preload %lld\n", i, expected[i], actual[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (expected.size() != actual.size()) {
+    std::printf("log lengths differ: glibc %zu, preload %zu\n", expected.size(), actual.size());
+    return EXIT_FAILURE;
+  }
+
+  std::printf("preload matches glibc over %zu entries\n", expected.size());
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+  bool load_glibc(random_functions& fn)
+  {
+    void* const libc = dlopen("libc.so.6", RTLD_NOW | RTLD_NOLOAD);
+    if (libc == nullptr)
+      return false;
+
+    const auto load = [libc](auto& function, const char* name) {
+      function = reinterpret_cast<std::remove_reference_t<decltype(function)>>(dlsym(libc, name));
+      return function != nullptr;
+    };
+
+    return load(fn.random, "random") && load(fn.srandom, "srandom")
+      && load(fn.rand, "rand") && load(fn.srand, "srand")
+      && load(fn.initstate, "initstate") && load(fn.setstate, "setstate");
+  }
+
+  std::vector<long long> run_scenario(const random_functions& fn)
+  {
+    // buffer sizes select the types: 0 for 8, 1 for 32, 2 for 64, 3 for 128 and 4
+    // for 256 or more bytes, while fewer than 8 bytes are rejected
+    struct state_buffers
+    {
+      alignas(std::int32_t) char type_0[8];
+      alignas(std::int32_t) char type_1[32];
+      alignas(std::int32_t) char type_2[64];
+      alignas(std::int32_t) char type_3[128];
+      alignas(std::int32_t) char type_4[256];
+      alignas(std::int32_t) char large[300];
+      alignas(std::int32_t) char small[7];
+      alignas(std::int32_t) char copy[128];
+      alignas(std::int32_t) char invalid[128];
+    };
+
+    static state_buffers buffers;
+    buffers = {};
+    const std::array<char*, 9> known = {
+      buffers.type_0, buffers.type_1, buffers.type_2, buffers.type_3, buffers.type_4,
+      buffers.large, buffers.small, buffers.copy, buffers.invalid};
+
+    std::vector<long long> log;
+    const auto values = [&](int count) {
+      for (int i = 0; i < count; ++i)
+        log.push_back(fn.random());
+    };
+
+    // buffers are logged by index, other buffers (the default state) as -1 and
+    // failure as -2 followed by errno
+    const auto buffer = [&](char* state) {
+      if (state == nullptr) {
+        log.push_back(-2);
+        log.push_back(errno);
+        return;
+      }
+
+      long long index = -1;
+      for (std::size_t i = 0; i < known.size(); ++i) {
+        if (known[i] == state)
+          index = static_cast<long long>(i);
+      }
+      log.push_back(index);
+    };
+
+    // the default state, seed 0, and rand()
+    values(700);
+    log.push_back(fn.rand());
+    log.push_back(fn.rand());
+    fn.srand(0);
+    values(40);
+    fn.srandom(12345);
+    values(600);
+    fn.srandom(0xDEADBEEFu);
+    values(40);
+
+    // a failing initstate() leaves the state unchanged
+    errno = 0;
+    buffer(fn.initstate(3, buffers.small, sizeof buffers.small));
+    values(5);
+
+    // every type
+    char* const default_state = fn.initstate(7, buffers.type_0, sizeof buffers.type_0);
+    buffer(default_state);
+    values(20);
+    buffer(fn.initstate(7, buffers.type_1, sizeof buffers.type_1));
+    values(40);
+    buffer(fn.initstate(8, buffers.type_2, sizeof buffers.type_2));
+    values(40);
+    log.push_back(fn.rand());
+    buffer(fn.initstate(9, buffers.type_3, sizeof buffers.type_3));
+    values(400);
+    buffer(fn.initstate(10, buffers.type_4, sizeof buffers.type_4));
+    values(200);
+    buffer(fn.initstate(0x80000001u, buffers.large, sizeof buffers.large));
+    values(30);
+
+    // seed 0 for every type
+    for (char* state : {buffers.type_0, buffers.type_1, buffers.type_2, buffers.type_3, buffers.type_4}) {
+      buffer(fn.setstate(state));
+      fn.srandom(0);
+      values(30);
+    }
+
+    // switching between buffers continues each sequence
+    buffer(fn.setstate(buffers.type_3));
+    values(300);
+    fn.srandom(77);
+    values(50);
+    buffer(fn.setstate(buffers.type_0));
+    values(10);
+    buffer(fn.setstate(buffers.type_1));
+    values(30);
+    buffer(fn.setstate(default_state));
+    values(400);
+    buffer(fn.setstate(buffers.type_2));
+    fn.srandom(5);
+    values(30);
+
+    // a copy of a buffer, made once it is switched away from, continues the same
+    // sequence as the original
+    buffer(fn.setstate(buffers.type_3));
+    values(2);
+    buffer(fn.setstate(buffers.type_4));
+    std::memcpy(buffers.copy, buffers.type_3, sizeof buffers.copy);
+    buffer(fn.setstate(buffers.copy));
+    values(50);
+    buffer(fn.setstate(buffers.type_3));
+    values(50);
+
+    // a failing setstate() leaves the state unchanged
+    const std::int32_t invalid_type = -1;
+    std::memcpy(buffers.invalid, &invalid_type, sizeof invalid_type);
+    errno = 0;
+    buffer(fn.setstate(buffers.invalid));
+    values(10);
+
+    // leave the default state current again
+    buffer(fn.setstate(default_state));
+    return log;
+  }
+}
@@ -0,0 +1,288 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+// USAGE: (program)
+// Verifies that each solver reconstructs its generator from the output of a seeded
+// generator, and that the reconstructed generator predicts the output that follows.
+//
+// Partial observations are routed through the observation models (see
+// observation_model.hpp), which select the low bit, interval, modular and combined
+// solvers. Streams that do not come from a generator are checked to be rejected by
+// the modular solver, the classifier and the stream filters.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <array>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "additive_solver.hpp"
+#include "drand48_solver.hpp"
+#include "generator_classifier.hpp"
+#include "interval_solver.hpp"
+#include "mt19937_solver.hpp"
+#include "observation_model.hpp"
+#include "prng.hpp"
+#include "rand_r_solver.hpp"
+#include "ranlux_solver.hpp"
+#include "stream_filter.hpp"
+#include "subtractive_solver.hpp"
+
+namespace
+{
+  using namespace predicting_random;
+
+  /**
+   * \brief The number of outputs compared after a generator is reconstructed.
+   */
+  constexpr int predicted_outputs = 1000;
+
+  /**
+   * \brief Prints \a name if \a passed is \c false, returning \a passed.
+   */
+  bool check(bool passed, const char* name);
+
+  /**
+   * \brief Returns \c true if \a solved produces the same next outputs as \a truth,
+   *        after \a project is applied to the outputs of \a truth.
+   */
+  template<typename Solved, typename Truth, typename Project>
+  bool predicts(std::optional<Solved> solved, Truth& truth, Project project);
+
+  /**
+   * \brief Returns \c true if the solver of \a Model reconstructs a generator
+   *        seeded by \a seed from at most \a limit observations, which then
+   *        predicts its output.
+   */
+  template<observation_model Model>
+  bool solves_model(unsigned seed, std::size_t limit);
+
+  /**
+   * \brief Returns \c true if \a Solver reconstructs \a truth from its output,
+   *        within \a limit outputs, and then predicts it.
+   */
+  template<typename Solver, typename Generator>
+  bool solves_exact(Solver&& solver, Generator truth, std::size_t limit);
+
+  bool check_observation_models();
+  bool check_interval_solver();
+  bool check_other_generators();
+  bool check_rejection();
+}
+
+int main()
+{
+  bool passed = true;
+  passed &= check_observation_models();
+  passed &= check_interval_solver();
+  passed &= check_other_generators();
+  passed &= check_rejection();
+
+  if (!passed)
+    return EXIT_FAILURE;
+
+  std::printf("%s\n", "every solver predicts its generator");
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+  bool check(bool passed, const char* name)
+  {
+    if (!passed)
+      std::printf("%s: failed\n", name);
+    return passed;
+  }
+
+  template<typename Solved, typename Truth, typename Project>
+  bool predicts(std::optional<Solved> solved, Truth& truth, Project project)
+  {
+    if (!solved)
+      return false;
+
+    for (int i = 0; i < predicted_outputs; ++i) {
+      if ((*solved)() != project(truth()))
+        return false;
+    }
+
+    return true;
+  }
+
+  template<observation_model Model>
+  bool solves_model(unsigned seed, std::size_t limit)
+  {
+    reference_generator truth(seed);
+    model_solver<Model> solver;
+    for (std::size_t i = 0; i < limit; ++i) {
+      if (auto gen = solver.feed(Model::observe(truth))) {
+        using generator_type = typename model_solver<Model>::generator_type;
+        constexpr auto mask = generator_type::max();
+        return predicts(gen, truth, [](std::uint32_t value) { return value & mask; });
+      }
+    }
+
+    return false;
+  }
+
+  template<typename Solver, typename Generator>
+  bool solves_exact(Solver&& solver, Generator truth, std::size_t limit)
+  {
+    for (std::size_t i = 0; i < limit; ++i) {
+      if (auto gen = solver.feed(truth()))
+        return predicts(gen, truth, [](auto value) { return value; });
+    }
+
+    return false;
+  }
+
+  bool check_observation_models()
+  {
+    using namespace observation;
+
+    bool passed = true;
+    passed &= check(solves_model<exact>(1, 1000), "exact");
+    passed &= check(solves_model<mask<1>>(2, 200), "mask<1>");
+    passed &= check(solves_model<mask<16>>(3, 200), "mask<16>");
+    passed &= check(solves_model<shift<8>>(4, 5000), "shift<8>");
+    passed &= check(solves_model<shift<8, scale<1000000>>>(5, 5000), "shift<8, scale<1000000>>");
+    passed &= check(solves_model<mod<100>>(6, 10000), "mod<100>");
+    passed &= check(solves_model<mod<52>>(7, 10000), "mod<52>");
+    passed &= check(solves_model<combine<31>>(8, 100), "combine<31>");
+    passed &= check(solves_model<combine<32, call_order::low_first>>(9, 100), "combine<32, low_first>");
+    passed &= check(solves_model<combine<16>>(10, 200), "combine<16>");
+    passed &= check(solves_model<combine<16, call_order::low_first>>(11, 200), "combine<16, low_first>");
+    return passed;
+  }
+
+  bool check_interval_solver()
+  {
+    bool passed = true;
+
+    // intervals too wide for the lattice are rejected without being retained
+    interval_solver wide;
+    reference_generator gen(12);
+    const auto none = wide.feed(shifted_output(gen() >> 24, 24));
+    passed &= check(!none && wide.impractical() && wide.size() == 0, "interval_solver rejects >> 24");
+
+    return passed;
+  }
+
+  bool check_other_generators()
+  {
+    bool passed = true;
+
+    passed &= check(solves_exact(rand_r_solver{}, rand_r_generator(12345u), 2), "rand_r");
+    passed &= check(solves_exact(drand48_solver{}, drand48_generator::from_seed(42), 4), "lrand48");
+
+    {
+      auto truth = drand48_generator::from_seed(43);
+      drand48_solver solver(drand48_output::mrand48);
+      std::optional<drand48_generator> gen;
+      for (int i = 0; i < 4 && !gen; ++i)
+        gen = solver.feed(static_cast<std::uint32_t>(truth.mrand48()));
+      passed &= check(gen && gen->state() == truth.state(), "mrand48");
+    }
+
+    {
+      auto truth = drand48_generator::from_seed(44);
+      const auto gen = drand48_solver::from_double(truth.drand48());
+      passed &= check(gen && gen->state() == truth.state(), "drand48");
+    }
+
+    passed &= check(solves_exact(ranlux24_base_solver{}, ranlux24_base_generator(7), 100), "ranlux24_base");
+    passed &= check(solves_exact(ranlux48_base_solver{}, ranlux48_base_generator(7), 100), "ranlux48_base");
+    passed &= check(solves_exact(knuth_subtractive_solver{}, knuth_subtractive_generator(-5), 55), "knuth_subtractive");
+    passed &= check(solves_exact(ran3_solver{}, ran3_generator(-5), 55), "ran3");
+
+    {
+      std::mt19937 words(99);
+      subtractive_generator::table_type table;
+      for (int i = 0; i < 55; ++i)
+        table.push(static_cast<std::uint32_t>(words()));
+      passed &= check(solves_exact(subtractive_solver{}, subtractive_generator(table), 2000), "subtractive");
+    }
+
+    passed &= check(solves_exact(additive_lagged_solver<7, 3>{}, additive_lagged_generator<7, 3>(3), 1000), "additive<7, 3>");
+    passed &= check(solves_exact(additive_lagged_solver<607, 273>{}, additive_lagged_generator<607, 273>(3), 10000), "additive<607, 273>");
+
+    {
+      // the solved generator is compared against std::mt19937 itself
+      std::mt19937 truth(2024);
+      passed &= check(solves_exact(mt19937_solver{}, truth, 624), "mt19937");
+
+      mt19937_generator gen(2024);
+      for (int i = 0; i < 1000; ++i)
+        (void)gen();
+      passed &= check(mt19937_generator{gen.state()} == gen, "mt19937_generator state round trip");
+    }
+
+    return passed;
+  }
+
+  bool check_rejection()
+  {
+    bool passed = true;
+
+    std::mt19937 other(5);
+    std::vector<std::uint32_t> foreign(400);
+    for (auto& value : foreign)
+      value = static_cast<std::uint32_t>(other() >> 1);
+
+    reference_generator type3(5);
+    std::vector<std::uint32_t> native(400);
+    for (auto& value : native)
+      value = type3();
+
+    additive_lagged_generator<55, 24> lagged(5);
+    std::vector<std::uint32_t> additive(400);
+    for (auto& value : additive)
+      value = lagged();
+
+    {
+      modular_solver<100> solver;
+      for (const auto value : foreign)
+        (void)solver.feed(value % 100);
+      passed &= check(solver.failed(), "modular_solver rejects mt19937");
+    }
+
+    {
+      const auto native_class = classify_generator(native);
+      const auto additive_class = classify_generator(additive);
+      const auto foreign_class = classify_generator(foreign);
+      passed &= check(native_class.family == generator_family::glibc_type3, "classify TYPE_3");
+      passed &= check(
+        additive_class.family == generator_family::additive_lagged_fibonacci
+          && additive_class.long_lag == 55 && additive_class.short_lag == 24,
+        "classify (55, 24)");
+      passed &= check(foreign_class.family == generator_family::unknown, "classify mt19937");
+    }
+
+    {
+      type3_filter accept, reject;
+      for (const auto value : native)
+        (void)accept.feed(value);
+      for (const auto value : foreign)
+        (void)reject.feed(value);
+      passed &= check(accept.verdict() == filter_verdict::accepted, "type3_filter accepts TYPE_3");
+      passed &= check(reject.verdict() == filter_verdict::rejected, "type3_filter rejects mt19937");
+
+      // interleave the streams, TYPE_3 first
+      std::vector<std::uint32_t> outputs;
+      for (std::size_t i = 0; i < native.size(); ++i) {
+        outputs.push_back(native[i]);
+        outputs.push_back(foreign[i]);
+      }
+      std::array<std::uint8_t, 2> verdicts;
+      const auto count = filter_type3_streams(outputs, verdicts);
+      passed &= check(count == 1 && verdicts[0] == 1 && verdicts[1] == 0, "filter_type3_streams");
+    }
+
+    return passed;
+  }
+}
@@ -0,0 +1,147 @@
+//          Copyright surrealwaffle 2024.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+// USAGE: (program)
+// Verifies that spsc_ring hands every value from a producer thread to a consumer
+// thread exactly once and in order.
+//
+// The producer pushes consecutive integers and the consumer checks that it reads
+// them back in sequence. Each side rotates through every way it has of exchanging
+// values, single and batched, and the ring is small so that its storage wraps
+// around many times and each side frequently finds it full or empty.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "spsc_ring.hpp"
+
+namespace
+{
+  using namespace predicting_random;
+
+  using ring_type = spsc_ring<std::uint64_t, 64>;
+
+  /**
+   * \brief The number of values handed from the producer to the consumer.
+   */
+  constexpr std::uint64_t total_values = 2'000'000;
+
+  /**
+   * \brief Pushes the values `0, 1, ..., total_values - 1` into \a ring.
+   */
+  void produce(ring_type& ring);
+
+  /**
+   * \brief Pops #total_values values from \a ring.
+   *
+   * \return The number of values that were out of sequence.
+   */
+  std::uint64_t consume(ring_type& ring);
+}
+
+int main()
+{
+  ring_type ring;
+  std::uint64_t errors = 0;
+  {
+    std::jthread consumer([&] { errors = consume(ring); });
+    produce(ring);
+  }
+
+  if (errors != 0) {
+    std::printf("%llu values were out of sequence\n", static_cast<unsigned long long>(errors));
+    return EXIT_FAILURE;
+  }
+
+  std::printf("spsc_ring handed over %llu values in order\n", static_cast<unsigned long long>(total_values));
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+  void produce(ring_type& ring)
+  {
+    std::vector<std::uint64_t> batch;
+    std::uint64_t next = 0;
+    for (int round = 0; next < total_values; ++round) {
+      switch (round % 3) {
+      case 0: // try_push
+        if (ring.try_push(next))
+          ++next;
+        break;
+
+      case 1: { // push, of a batch that may not fit
+        batch.resize(std::min<std::uint64_t>(1 + round % 100, total_values - next));
+        for (std::size_t i = 0; i < batch.size(); ++i)
+          batch[i] = next + i;
+        next += ring.push(batch);
+        break;
+      }
+
+      case 2: { // write_segments and publish
+        const auto [first, second] = ring.write_segments(16);
+        const auto room = std::min<std::uint64_t>(first.size() + second.size(), total_values - next);
+        const auto split = std::min<std::uint64_t>(room, first.size());
+        for (std::uint64_t i = 0; i < split; ++i)
+          first[i] = next + i;
+        for (std::uint64_t i = split; i < room; ++i)
+          second[i - split] = next + i;
+        ring.publish(room);
+        next += room;
+        break;
+      }
+      }
+
+      if (round % 64 == 0)
+        std::this_thread::yield();
+    }
+  }
+
+  std::uint64_t consume(ring_type& ring)
+  {
+    std::uint64_t expected = 0;
+    std::uint64_t errors = 0;
+    const auto check = [&](std::span<const std::uint64_t> values) {
+      for (const auto value : values)
+        errors += value != expected++;
+    };
+
+    for (int round = 0; expected < total_values; ++round) {
+      switch (round % 3) {
+      case 0: // try_pop
+        if (const auto value = ring.try_pop())
+          check(std::span(&*value, 1));
+        break;
+
+      case 1: // drain
+        ring.drain(check);
+        break;
+
+      case 2: { // read_segments and consume, releasing only part of them
+        const auto [first, second] = ring.read_segments(8);
+        const auto count = std::min<std::size_t>(first.size() + second.size(), 1 + round % 50);
+        const auto split = std::min(count, first.size());
+        check(first.first(split));
+        check(second.first(count - split));
+        ring.consume(count);
+        break;
+      }
+      }
+
+      if (round % 64 == 0)
+        std::this_thread::yield();
+    }
+
+    return errors;
+  }
+}